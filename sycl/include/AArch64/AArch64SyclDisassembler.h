@@ -10,6 +10,29 @@ public:
   virtual std::unique_ptr<InstInfoContainer> batch_disassemble(uint64_t base_addr,
                                              std::vector<uint8_t> &content,
                                              int step_size = 4) override;
+  virtual std::unique_ptr<InstInfoContainer>
+  batch_disassemble_ranges(std::vector<uint8_t> &content,
+                           const std::vector<DecodeRange> &ranges,
+                           int step_size,
+                           const std::vector<uint64_t> *offsets =
+                               nullptr) override;
+  virtual std::unique_ptr<InstInfoContainer>
+  batch_disassemble_selected(uint64_t base_addr, std::vector<uint8_t> &content,
+                             int step_size,
+                             const std::vector<uint64_t> &offsets) override;
+  virtual std::unique_ptr<InstInfoContainer>
+  batch_disassemble_offsets(uint64_t base_addr, std::vector<uint8_t> &content,
+                            const std::vector<uint64_t> &offsets) override;
+  virtual std::vector<FunctionCandidate>
+  function_starts(InstInfoContainer &insts,
+                  std::vector<uint8_t> &content) override;
+  virtual std::vector<ResolvedAddress>
+  resolve_address_pairs(InstInfoContainer &insts,
+                        std::vector<uint8_t> &content,
+                        unsigned window = 8) override;
+  virtual std::vector<JumpTable>
+  find_jump_tables(InstInfoContainer &insts, std::vector<uint8_t> &content,
+                   const std::vector<uint8_t> &mask) override;
 };
 } // namespace gapstone
 
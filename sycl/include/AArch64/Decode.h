@@ -39,8 +39,17 @@ namespace gapstone {
 namespace AArch64Table {
 #define GET_REGINFO_MC_DESC
 #include "AArch64GenRegisterInfo.inc"
+#define GET_INSTRINFO_MC_DESC
+#include "AArch64GenInstrInfo.inc"
 } // namespace AArch64Table
 } // namespace gapstone
+static const MCInstrDesc &getMCID(unsigned Opcode) {
+  constexpr unsigned NumOpcode =
+      sizeof(gapstone::AArch64Table::llvm::AArch64Descs.Insts) /
+      sizeof(llvm::MCInstrDesc);
+  return *(gapstone::AArch64Table::llvm::AArch64Descs.Insts + NumOpcode - 1 -
+           Opcode);
+}
 #define AArch64MCRegisterClasses                                               \
   gapstone::AArch64Table::llvm::AArch64MCRegisterClasses
 
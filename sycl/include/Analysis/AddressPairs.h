@@ -0,0 +1,22 @@
+#ifndef GAPSTONE_ANALYSIS_ADDRESS_PAIRS_H
+#define GAPSTONE_ANALYSIS_ADDRESS_PAIRS_H
+#include <cstdint>
+
+namespace gapstone {
+
+// An absolute address built in two steps, e.g. AArch64 adrp followed by an
+// add or a load/store on the same register.
+struct ResolvedAddress {
+  // Address of the page-forming instruction.
+  uint64_t page_insn;
+  // Address of the instruction completing the address.
+  uint64_t consumer;
+  uint64_t address;
+  // TargetKind::Immediate when the address is materialized in a register,
+  // TargetKind::Memory when the consumer accesses it.
+  uint8_t kind;
+};
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_ADDRESS_PAIRS_H
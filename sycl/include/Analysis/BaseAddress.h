@@ -0,0 +1,64 @@
+#ifndef GAPSTONE_ANALYSIS_BASE_ADDRESS_H
+#define GAPSTONE_ANALYSIS_BASE_ADDRESS_H
+#include "SyclDisassembler.h"
+#include <cstdint>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace gapstone {
+
+struct SupersetView;
+
+// Candidate load addresses low, low + alignment, ... below high.
+struct BaseSearch {
+  uint64_t low = 0;
+  uint64_t high = uint64_t(1) << 32;
+  uint64_t alignment = 0x1000;
+  // Width and byte order of the absolute pointers stored in the image.
+  unsigned pointer_size = 4;
+  bool big_endian = false;
+  // Shortest printable run counted as a string.
+  unsigned min_string = 4;
+};
+
+struct BaseCandidate {
+  uint64_t base;
+  // Absolute pointers landing on an anchor when loaded at base.
+  uint64_t hits;
+};
+
+/// infer_base_address - Scores every candidate base of a headerless image.
+///
+///   Anchors are the image offsets that must be meaningful at any base: the
+///   destinations of the PC-relative memory references, and of the branches
+///   and calls landing on an instruction that decodes, made by the
+///   linear-sweep instructions; and the starts of NUL-separated printable
+///   strings. Absolute pointers are the aligned pointer_size words of the
+///   image plus the immediates the linear-sweep instructions move into
+///   registers. Loaded at the right base, many
+///   pointers hit anchors. Every pointer votes, in parallel, for each
+///   candidate placing it inside the image whose offset is an anchor, so
+///   the work is pointers * image size / alignment rather than pointers *
+///   candidates.
+///
+/// @param view         - Superset decode of image, made at base address 0.
+/// @param image        - Device array of image_size bytes.
+/// @param count        - Number of best candidates to return.
+/// @return             - The best candidates by decreasing hits.
+std::vector<BaseCandidate> infer_base_address(sycl::queue &q,
+                                              const SupersetView &view,
+                                              const uint8_t *image,
+                                              uint64_t image_size,
+                                              const BaseSearch &search,
+                                              unsigned count = 10);
+
+/// infer_base_address - Host wrapper.
+std::vector<BaseCandidate> infer_base_address(sycl::queue &q,
+                                              const InstInfoContainer &insts,
+                                              const std::vector<uint8_t> &image,
+                                              const BaseSearch &search,
+                                              unsigned count = 10);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_BASE_ADDRESS_H
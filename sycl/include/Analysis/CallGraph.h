@@ -0,0 +1,59 @@
+#ifndef GAPSTONE_ANALYSIS_CALL_GRAPH_H
+#define GAPSTONE_ANALYSIS_CALL_GRAPH_H
+#include "Analysis/Partition.h"
+#include <boost/graph/compressed_sparse_row_graph.hpp>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace gapstone {
+
+struct CallGraphVertex {
+  std::string name;
+  // Entry address of a function, 0 for an import.
+  uint64_t address;
+};
+
+struct CallGraphEdge {
+  // Address of the call instruction.
+  uint64_t call_site;
+};
+
+// Whole-binary call graph in Boost's CSR representation. Vertices
+// [0, functions) are the ProgramPartition functions in order, the rest are
+// imports; out-edges are grouped by caller.
+typedef boost::compressed_sparse_row_graph<boost::directedS, CallGraphVertex,
+                                           CallGraphEdge>
+    CallGraph;
+
+// A memory slot the loader fills with the address of an imported symbol,
+// such as an ELF GOT entry with a JUMP_SLOT or GLOB_DAT relocation.
+struct ImportSlot {
+  uint64_t address;
+  std::string name;
+};
+
+/// build_call_graph - Resolves every call instruction of the partition.
+///
+///   Direct calls go to the function at the destination, or to the import a
+///   PLT stub there jumps through. Calls through memory (call [rip+slot]) and
+///   register calls whose operand is loaded from a RIP-relative slot just
+///   before (mov reg, [rip+slot]; call reg) go to the import of the slot.
+///   Call sites are found on the device; calls that resolve to nothing known
+///   are dropped.
+CallGraph build_call_graph(sycl::queue &q, const InstInfoContainer &insts,
+                           const ProgramPartition &partition,
+                           const std::vector<ImportSlot> &imports);
+
+/// write_call_graph_graphml - Writes the graph through boost::write_graphml,
+///   with name and address vertex attributes and a call_site edge attribute.
+void write_call_graph_graphml(std::ostream &os, CallGraph &graph);
+
+/// write_call_graph_dot - Writes the graph through boost::write_graphviz_dp.
+void write_call_graph_dot(std::ostream &os, CallGraph &graph);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_CALL_GRAPH_H
@@ -0,0 +1,42 @@
+#ifndef GAPSTONE_ANALYSIS_CODE_PROBABILITY_H
+#define GAPSTONE_ANALYSIS_CODE_PROBABILITY_H
+#include "SyclDisassembler.h"
+#include <cstdint>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace gapstone {
+
+struct SupersetView;
+
+/// code_probabilities - Estimates for every entry the probability that it
+///   starts a real instruction, in the spirit of probabilistic disassembly.
+///
+///   Entries whose fall-through chain runs into undecodable bytes (see
+///   prune_invalid_chains) are data. The others get a prior from their own
+///   decode: direct control transfers make an entry likely, traps and
+///   offsets that other instructions read as memory operands make it
+///   unlikely. Every round then, in parallel over all entries,
+///   - raises an entry to the probability of its most likely predecessor
+///     (fall-through, branch or call), as code only flows into code,
+///   - discounts it by the most likely instruction overlapping it,
+///   - and bounds it by what overlapping instructions leave of its
+///     fall-through successor.
+///   Rounds are damped and repeat until no probability moves by more than
+///   epsilon or max_rounds is reached.
+///
+/// @param probabilities - Device array of view.tasks receiving the result.
+/// @return              - The number of rounds run.
+unsigned code_probabilities(sycl::queue &q, const SupersetView &view,
+                            float *probabilities, unsigned max_rounds = 64,
+                            float epsilon = 1e-4f);
+
+/// code_probabilities - Host wrapper returning the probabilities.
+std::vector<float> code_probabilities(sycl::queue &q,
+                                      const InstInfoContainer &insts,
+                                      unsigned max_rounds = 64,
+                                      float epsilon = 1e-4f);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_CODE_PROBABILITY_H
@@ -0,0 +1,113 @@
+#ifndef GAPSTONE_ANALYSIS_CONTROL_FLOW_H
+#define GAPSTONE_ANALYSIS_CONTROL_FLOW_H
+#include "SyclDisassembler.h"
+#include <cstdint>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace gapstone {
+
+struct SupersetView;
+
+namespace EdgeKind {
+enum : uint8_t {
+  FallThrough = 0,
+  // Taken side of a conditional branch.
+  ConditionalBranch = 1,
+  // Unconditional direct branch.
+  Branch = 2,
+  Call = 3,
+  // Indirect jump through a recovered jump table.
+  JumpTable = 4,
+};
+} // namespace EdgeKind
+
+static inline const char *edge_kind_name(uint8_t Kind) {
+  switch (Kind) {
+  case EdgeKind::FallThrough:
+    return "fallthrough";
+  case EdgeKind::ConditionalBranch:
+    return "conditional";
+  case EdgeKind::Branch:
+    return "branch";
+  case EdgeKind::Call:
+    return "call";
+  case EdgeKind::JumpTable:
+    return "jumptable";
+  default:
+    return "unknown";
+  }
+}
+
+// Control-flow edges between superset entries in compressed sparse row form.
+// The out-edges of entry v are columns[offsets[v]] .. columns[offsets[v+1]-1],
+// sorted by destination.
+struct ControlFlowGraph {
+  uint64_t num_vertices = 0;
+  uint64_t base_addr = 0;
+  int step_size = 1;
+  // The ranges of a packed decode, see InstInfoContainer::ranges.
+  std::vector<DecodeRange> ranges;
+  std::vector<uint64_t> offsets;
+  std::vector<uint64_t> columns;
+  std::vector<uint8_t> kinds;
+
+  uint64_t num_edges() const { return columns.size(); }
+  uint64_t address(uint64_t v) const {
+    return range_address(ranges.data(), ranges.size(), base_addr,
+                         v * step_size);
+  }
+  // Vertex at address, or num_vertices if it has none.
+  uint64_t index_of(uint64_t address) const {
+    uint64_t offset =
+        range_offset(ranges.data(), ranges.size(), base_addr, address);
+    if (offset == NoOffset || offset % step_size ||
+        offset / step_size >= num_vertices)
+      return num_vertices;
+    return offset / step_size;
+  }
+};
+
+// Kernel-side view of a ControlFlowGraph.
+struct ControlFlowView {
+  const uint64_t *offsets;
+  const uint64_t *columns;
+  const uint8_t *kinds;
+  uint64_t num_vertices;
+};
+
+// Device-resident copy of a ControlFlowGraph.
+class DeviceControlFlowGraph {
+  sycl::queue &q;
+  ControlFlowView View;
+
+public:
+  DeviceControlFlowGraph(sycl::queue &qq, const ControlFlowGraph &cfg);
+  DeviceControlFlowGraph(const DeviceControlFlowGraph &) = delete;
+  DeviceControlFlowGraph &operator=(const DeviceControlFlowGraph &) = delete;
+  ~DeviceControlFlowGraph();
+
+  const ControlFlowView &view() const { return View; }
+};
+
+/// build_control_flow_graph - Emits the fall-through, branch and call edges
+///   of every selected entry on the device, then orders and compacts them
+///   into CSR arrays. A destination reached both by falling through and by a
+///   branch yields a single edge of the branch kind.
+///
+/// @param mask         - Device array of view.tasks flags selecting the
+///                       entries that take part, or nullptr for every valid
+///                       entry.
+ControlFlowGraph build_control_flow_graph(sycl::queue &q,
+                                          const SupersetView &view,
+                                          const uint8_t *mask = nullptr);
+
+/// build_control_flow_graph - Host wrapper; an empty mask selects every
+///   valid entry.
+ControlFlowGraph
+build_control_flow_graph(sycl::queue &q, const InstInfoContainer &insts,
+                         const std::vector<uint8_t> &mask = {});
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_CONTROL_FLOW_H
@@ -0,0 +1,82 @@
+#ifndef GAPSTONE_ANALYSIS_DIFF_H
+#define GAPSTONE_ANALYSIS_DIFF_H
+#include "Analysis/Partition.h"
+#include <cstdint>
+#include <vector>
+
+namespace gapstone {
+
+namespace MatchKind {
+enum : uint8_t {
+  // The instruction sequences are identical and unique in both builds.
+  Hash = 0,
+  // Unmatched functions at the same rank between two hash matches.
+  Position = 1,
+};
+} // namespace MatchKind
+
+namespace DiffOp {
+enum : uint8_t {
+  Equal = 0,
+  // Only in the new build.
+  Insert = 1,
+  // Only in the old build.
+  Delete = 2,
+};
+} // namespace DiffOp
+
+struct DiffEdit {
+  uint8_t op;
+  // Superset entries of the instruction in each build, NoEntry on the side
+  // that lacks it.
+  uint64_t old_entry;
+  uint64_t new_entry;
+
+  static constexpr uint64_t NoEntry = ~uint64_t(0);
+};
+
+struct FunctionDiff {
+  uint64_t old_function;
+  uint64_t new_function;
+  uint8_t kind;
+  // Edit script turning the old instructions into the new ones, empty if
+  // they are equal.
+  std::vector<DiffEdit> edits;
+};
+
+struct BinaryDiff {
+  // Sorted by old function.
+  std::vector<FunctionDiff> matches;
+  // Unmatched functions of either build.
+  std::vector<uint64_t> removed;
+  std::vector<uint64_t> added;
+};
+
+/// function_instructions - Superset entries of a function, block after
+///   block in address order.
+std::vector<uint64_t> function_instructions(const InstInfoContainer &insts,
+                                            const ProgramPartition &partition,
+                                            uint64_t function);
+
+/// diff_programs - Matches the functions of two builds and diffs the matched
+///   pairs. Instructions are compared by opcode, registers and immediates,
+///   leaving out only the PC-relative destinations, so code that only moved
+///   or refers to moved addresses compares equal. Functions with a
+///   unique sequence hash in both builds are matched first; the remaining
+///   ones are paired by rank between consecutive hash matches. The
+///   instruction sequences of each pair are diffed with Myers' algorithm.
+///   Sequence extraction and diffing are handed out to a pool of host
+///   threads.
+///
+/// @param max_edits    - Pairs needing more edits are reported as replaced
+///                       wholesale.
+/// @param threads      - Worker count, 0 for std::thread::hardware_concurrency.
+BinaryDiff diff_programs(InstInfoContainer &old_insts,
+                         const ProgramPartition &old_partition,
+                         InstInfoContainer &new_insts,
+                         const ProgramPartition &new_partition,
+                         uint64_t max_edits = 1024, unsigned threads = 0);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_DIFF_H
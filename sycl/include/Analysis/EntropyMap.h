@@ -0,0 +1,82 @@
+#ifndef GAPSTONE_ANALYSIS_ENTROPY_MAP_H
+#define GAPSTONE_ANALYSIS_ENTROPY_MAP_H
+#include "SyclDisassembler.h"
+#include <cstdint>
+#include <ostream>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace gapstone {
+
+struct SupersetView;
+
+// Bytes per window of the default map, and work-items per window.
+constexpr uint64_t EntropyWindowSize = 4096;
+constexpr uint64_t EntropyGroupSize = 256;
+// Code rarely exceeds this many bits per byte; compressed or encrypted data
+// sits just below 8.
+constexpr float PackedEntropy = 7.2f;
+
+struct EntropyMap {
+  uint64_t window = EntropyWindowSize;
+  // Byte entropy of every window in bits per byte, from 0 to 8. The last
+  // window may be shorter.
+  std::vector<float> entropy;
+  // Share of the step-aligned offsets of every window that decode, empty
+  // when the map was built without a decode.
+  std::vector<float> density;
+
+  uint64_t num_windows() const { return entropy.size(); }
+};
+
+/// entropy_map - Computes in one pass, one work-group per window, the byte
+///   histogram and entropy of every window and, given a decode, how many of
+///   its offsets decode.
+///
+/// @param content      - Device array of size bytes.
+/// @param window       - Bytes per window, at least 1.
+/// @param view         - Superset decode of content, or nullptr to skip the
+///                       density.
+EntropyMap entropy_map(sycl::queue &q, const uint8_t *content, uint64_t size,
+                       uint64_t window, const SupersetView *view);
+
+/// entropy_map - Host wrapper without density, cheap enough to run before
+///   the decode.
+EntropyMap entropy_map(sycl::queue &q, const std::vector<uint8_t> &content,
+                       uint64_t window = EntropyWindowSize);
+
+/// entropy_map - Host wrapper with the density of insts, decoded from
+///   content.
+EntropyMap entropy_map(sycl::queue &q, const InstInfoContainer &insts,
+                       const std::vector<uint8_t> &content,
+                       uint64_t window = EntropyWindowSize);
+
+/// decodable_windows - Flags the windows worth decoding: entropy at most
+///   max_entropy and, when the map has a density, density at least
+///   min_density.
+std::vector<uint8_t> decodable_windows(const EntropyMap &map,
+                                       float max_entropy = PackedEntropy,
+                                       float min_density = 0.0f);
+
+/// decodable_ranges - The parts of the ranges of the mapped buffer lying in
+///   flagged windows, split at the step-aligned window edges, for
+///   SyclDisassembler::batch_disassemble_ranges.
+///
+/// @param windows      - Flags from decodable_windows.
+std::vector<DecodeRange>
+decodable_ranges(const EntropyMap &map, const std::vector<uint8_t> &windows,
+                 const std::vector<DecodeRange> &ranges, int step_size);
+
+/// write_heatmap - Writes the map as text, 64 windows per line: the address
+///   of the first window, one character per window for the entropy and, if
+///   present, one per window for the density, from ' ' (low) to '@' (high).
+///
+/// @param ranges       - When the map covers a packed buffer, its ranges,
+///                       which the addresses follow.
+void write_heatmap(std::ostream &os, const EntropyMap &map,
+                   uint64_t base_addr,
+                   const std::vector<DecodeRange> &ranges = {});
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_ENTROPY_MAP_H
@@ -0,0 +1,78 @@
+#ifndef GAPSTONE_ANALYSIS_FUNCTION_STARTS_H
+#define GAPSTONE_ANALYSIS_FUNCTION_STARTS_H
+#include <cstdint>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace gapstone {
+
+struct SupersetView;
+
+// Evidence that an instruction starts a function. Targets set these bits per
+// superset entry, collect_function_candidates turns them into a score.
+namespace FunctionHint {
+enum : uint32_t {
+  None = 0,
+  // X86 endbr64/endbr32.
+  EndBranch = 1 << 0,
+  // Frame pointer setup, e.g. push rbp; mov rbp, rsp.
+  FramePrologue = 1 << 1,
+  // Stack adjustment or callee-saved spill without a frame pointer.
+  FramelessPrologue = 1 << 2,
+  // Aligned start right after int3/nop padding or a return.
+  AfterPadding = 1 << 3,
+  // Destination of a direct call.
+  CallTarget = 1 << 4,
+  // AArch64 bti c/jc landing pad.
+  LandingPad = 1 << 5,
+  // AArch64 paciasp/pacibsp return address signing.
+  PointerAuth = 1 << 6,
+};
+} // namespace FunctionHint
+
+struct FunctionCandidate {
+  uint64_t address;
+  uint32_t score;
+  uint32_t hints;
+};
+
+/// function_hint_score - Weight of the evidence in a FunctionHint bitfield.
+static inline uint32_t function_hint_score(uint32_t hints) {
+  uint32_t score = 0;
+  if (hints & FunctionHint::EndBranch)
+    score += 8;
+  if (hints & FunctionHint::CallTarget)
+    score += 8;
+  if (hints & FunctionHint::LandingPad)
+    score += 8;
+  if (hints & FunctionHint::PointerAuth)
+    score += 6;
+  if (hints & FunctionHint::FramePrologue)
+    score += 4;
+  if (hints & FunctionHint::FramelessPrologue)
+    score += 2;
+  if (hints & FunctionHint::AfterPadding)
+    score += 2;
+  return score;
+}
+
+/// mark_call_targets - Sets FunctionHint::CallTarget on every valid entry
+///   reached by a direct call from a valid entry.
+sycl::event mark_call_targets(sycl::queue &q, const SupersetView &view,
+                              uint32_t *hints);
+
+/// collect_function_candidates - Compacts the entries whose hints score at
+///   least min_score into a candidate list sorted by address.
+///
+/// @param hints        - Device array of FunctionHint bits, one per entry.
+std::vector<FunctionCandidate>
+collect_function_candidates(sycl::queue &q, const SupersetView &view,
+                            const uint32_t *hints, uint32_t min_score = 4);
+
+/// rank_function_candidates - Orders candidates by decreasing score, then by
+///   address.
+void rank_function_candidates(std::vector<FunctionCandidate> &candidates);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_FUNCTION_STARTS_H
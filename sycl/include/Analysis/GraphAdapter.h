@@ -0,0 +1,129 @@
+#ifndef GAPSTONE_ANALYSIS_GRAPH_ADAPTER_H
+#define GAPSTONE_ANALYSIS_GRAPH_ADAPTER_H
+// Boost.Graph view of a ControlFlowGraph. The CSR arrays are used in place,
+// so the Boost algorithms for IncidenceGraph, AdjacencyGraph and
+// VertexListGraph run on it without building an adjacency_list.
+#include "Analysis/ControlFlow.h"
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <boost/iterator/counting_iterator.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/property_map/property_map.hpp>
+#include <cstdint>
+#include <utility>
+
+namespace gapstone {
+
+// An edge is identified by its source and its position in the column array.
+struct CFGEdge {
+  uint64_t source;
+  uint64_t index;
+  bool operator==(const CFGEdge &Other) const { return index == Other.index; }
+  bool operator!=(const CFGEdge &Other) const { return index != Other.index; }
+};
+
+class CFGOutEdgeIterator
+    : public boost::iterator_facade<CFGOutEdgeIterator, CFGEdge,
+                                    std::random_access_iterator_tag, CFGEdge,
+                                    int64_t> {
+  uint64_t Source = 0;
+  uint64_t Index = 0;
+
+  friend class boost::iterator_core_access;
+  CFGEdge dereference() const { return {Source, Index}; }
+  bool equal(const CFGOutEdgeIterator &Other) const {
+    return Index == Other.Index;
+  }
+  void increment() { ++Index; }
+  void decrement() { --Index; }
+  void advance(int64_t N) { Index += N; }
+  int64_t distance_to(const CFGOutEdgeIterator &Other) const {
+    return int64_t(Other.Index) - int64_t(Index);
+  }
+
+public:
+  CFGOutEdgeIterator() = default;
+  CFGOutEdgeIterator(uint64_t Source, uint64_t Index)
+      : Source(Source), Index(Index) {}
+};
+
+struct CFGTraversalCategory : boost::incidence_graph_tag,
+                              boost::adjacency_graph_tag,
+                              boost::vertex_list_graph_tag {};
+
+} // namespace gapstone
+
+namespace boost {
+template <> struct graph_traits<gapstone::ControlFlowGraph> {
+  typedef uint64_t vertex_descriptor;
+  typedef gapstone::CFGEdge edge_descriptor;
+  typedef directed_tag directed_category;
+  typedef allow_parallel_edge_tag edge_parallel_category;
+  typedef gapstone::CFGTraversalCategory traversal_category;
+
+  typedef gapstone::CFGOutEdgeIterator out_edge_iterator;
+  typedef const uint64_t *adjacency_iterator;
+  typedef counting_iterator<uint64_t> vertex_iterator;
+
+  typedef uint64_t vertices_size_type;
+  typedef uint64_t edges_size_type;
+  typedef uint64_t degree_size_type;
+
+  static vertex_descriptor null_vertex() { return ~uint64_t(0); }
+};
+
+template <>
+struct property_map<gapstone::ControlFlowGraph, vertex_index_t> {
+  typedef typed_identity_property_map<uint64_t> type;
+  typedef type const_type;
+};
+} // namespace boost
+
+namespace gapstone {
+inline uint64_t source(const CFGEdge &E, const ControlFlowGraph &) {
+  return E.source;
+}
+
+inline uint64_t target(const CFGEdge &E, const ControlFlowGraph &G) {
+  return G.columns[E.index];
+}
+
+inline std::pair<CFGOutEdgeIterator, CFGOutEdgeIterator>
+out_edges(uint64_t V, const ControlFlowGraph &G) {
+  return {CFGOutEdgeIterator(V, G.offsets[V]),
+          CFGOutEdgeIterator(V, G.offsets[V + 1])};
+}
+
+inline uint64_t out_degree(uint64_t V, const ControlFlowGraph &G) {
+  return G.offsets[V + 1] - G.offsets[V];
+}
+
+inline std::pair<const uint64_t *, const uint64_t *>
+adjacent_vertices(uint64_t V, const ControlFlowGraph &G) {
+  const uint64_t *Columns = G.columns.data();
+  return {Columns + G.offsets[V], Columns + G.offsets[V + 1]};
+}
+
+inline std::pair<boost::counting_iterator<uint64_t>,
+                 boost::counting_iterator<uint64_t>>
+vertices(const ControlFlowGraph &G) {
+  return {boost::counting_iterator<uint64_t>(0),
+          boost::counting_iterator<uint64_t>(G.num_vertices)};
+}
+
+inline uint64_t num_vertices(const ControlFlowGraph &G) {
+  return G.num_vertices;
+}
+
+inline boost::typed_identity_property_map<uint64_t>
+get(boost::vertex_index_t, const ControlFlowGraph &) {
+  return {};
+}
+
+/// edge_kind - EdgeKind of an edge seen through the Boost.Graph view.
+inline uint8_t edge_kind(const CFGEdge &E, const ControlFlowGraph &G) {
+  return G.kinds[E.index];
+}
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_GRAPH_ADAPTER_H
@@ -0,0 +1,72 @@
+#ifndef GAPSTONE_ANALYSIS_HISTOGRAM_H
+#define GAPSTONE_ANALYSIS_HISTOGRAM_H
+#include "Analysis/Partition.h"
+#include <cstdint>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace gapstone {
+
+struct SupersetView;
+
+// Entries per work-group of the histogram kernel.
+constexpr uint64_t HistogramChunkSize = 4096;
+constexpr uint64_t HistogramGroupSize = 256;
+// Bins kept in work-group local memory at a time.
+constexpr uint32_t HistogramLocalBins = 4096;
+// Default number of hashed bins for 2- and 3-gram histograms.
+constexpr uint32_t NgramBins = 1 << 16;
+// Longest n-gram counted.
+constexpr unsigned MaxNgram = 3;
+
+// Group of an entry whose instruction is not counted.
+constexpr uint32_t NoGroup = ~uint32_t(0);
+
+// One histogram of num_bins counts per group of instructions.
+struct FeatureHistograms {
+  uint32_t num_groups = 0;
+  uint32_t num_bins = 0;
+  // num_bins counts per group, group after group.
+  std::vector<uint32_t> counts;
+
+  const uint32_t *histogram(uint64_t g) const {
+    return counts.data() + g * num_bins;
+  }
+};
+
+/// feature_histograms - Counts the opcodes (ngram 1), or the opcode n-grams
+///   along fall-through edges (ngram 2 or 3), of every group of entries.
+///   Opcodes are their own bin and must lie below num_bins; n-grams are
+///   hashed into num_bins bins. An n-gram only counts if all its
+///   instructions belong to the same group and none but the last ends the
+///   flow. Orders above MaxNgram are not supported.
+///
+///   The entries of each group are split into chunks of HistogramChunkSize,
+///   one work-group per chunk. A work-group counts its chunk into local
+///   memory with work-group atomics, HistogramLocalBins bins at a time, and
+///   then adds the non-zero bins to the global histogram of its group.
+///
+/// @param group_of     - Device array of view.tasks group indices, NoGroup
+///                       for entries that are not counted.
+FeatureHistograms feature_histograms(sycl::queue &q, const SupersetView &view,
+                                     const uint32_t *group_of,
+                                     uint32_t num_groups, unsigned ngram,
+                                     uint32_t num_bins);
+
+/// section_histograms - One histogram over the selected entries of every
+///   range of insts, a single one when it has no ranges; an empty mask
+///   selects every valid entry.
+FeatureHistograms section_histograms(sycl::queue &q,
+                                     const InstInfoContainer &insts,
+                                     const std::vector<uint8_t> &mask,
+                                     unsigned ngram, uint32_t num_bins);
+
+/// function_histograms - One histogram per function of partition.
+FeatureHistograms function_histograms(sycl::queue &q,
+                                      const InstInfoContainer &insts,
+                                      const ProgramPartition &partition,
+                                      unsigned ngram, uint32_t num_bins);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_HISTOGRAM_H
@@ -0,0 +1,94 @@
+#ifndef GAPSTONE_ANALYSIS_JUMP_TABLES_H
+#define GAPSTONE_ANALYSIS_JUMP_TABLES_H
+#include <cstdint>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace gapstone {
+
+struct ControlFlowGraph;
+struct InstInfoContainer;
+struct SupersetView;
+
+namespace JumpTableEncoding {
+enum : uint8_t {
+  // Entries hold absolute target addresses.
+  Absolute = 0,
+  // Entries hold signed offsets, target = base + (entry << shift).
+  Relative = 1,
+};
+} // namespace JumpTableEncoding
+
+struct JumpTable {
+  // Address of the indirect jump.
+  uint64_t jump;
+  uint64_t table;
+  uint64_t base;
+  uint8_t entry_size;
+  uint8_t shift;
+  uint8_t encoding;
+  // Number of leading entries that lead to valid instructions, filled in by
+  // validate_jump_tables.
+  uint32_t num_entries;
+};
+
+// Bytes of a loaded section, used to read table entries.
+struct DataRegion {
+  uint64_t address;
+  const uint8_t *data;
+  uint64_t size;
+};
+
+/// collect_indirect_jumps - Indices of the selected indirect jumps, compacted
+///   on the device.
+///
+/// @param mask         - Host flags selecting instructions, may be empty.
+std::vector<uint64_t> collect_indirect_jumps(sycl::queue &q,
+                                             const InstInfoContainer &insts,
+                                             const std::vector<uint8_t> &mask);
+
+/// preceding_instructions - Up to window instructions falling through into
+///   entry i, nearest first. Where several offsets fall into the same entry
+///   a selected one is preferred.
+///
+/// @param mask         - Host flags selecting instructions, may be empty.
+std::vector<uint64_t> preceding_instructions(const SupersetView &view,
+                                             const std::vector<uint8_t> &mask,
+                                             uint64_t i, unsigned window);
+
+/// validate_jump_tables - Reads up to max_entries entries of every table and
+///   checks all of them at once on the device: an entry is valid if its
+///   target is a decodable, selected instruction of the view. A table keeps
+///   the entries before its first invalid one; tables left empty are
+///   removed.
+///
+/// @param mask         - Device array of view.tasks flags, or nullptr.
+void validate_jump_tables(sycl::queue &q, const SupersetView &view,
+                          const uint8_t *mask,
+                          const std::vector<DataRegion> &regions,
+                          std::vector<JumpTable> &tables,
+                          uint32_t max_entries = 1024);
+
+/// validate_jump_tables - Host wrapper; an empty mask accepts every valid
+///   entry.
+void validate_jump_tables(sycl::queue &q, const InstInfoContainer &insts,
+                          const std::vector<uint8_t> &mask,
+                          const std::vector<DataRegion> &regions,
+                          std::vector<JumpTable> &tables,
+                          uint32_t max_entries = 1024);
+
+/// jump_table_target - Target of entry k of a table, false if the entry lies
+///   outside the regions.
+bool jump_table_target(const JumpTable &table,
+                       const std::vector<DataRegion> &regions, uint64_t k,
+                       uint64_t &target);
+
+/// add_jump_table_edges - Adds an EdgeKind::JumpTable edge from every jump to
+///   each distinct target of its table, keeping rows sorted by destination.
+void add_jump_table_edges(ControlFlowGraph &cfg,
+                          const std::vector<JumpTable> &tables,
+                          const std::vector<DataRegion> &regions);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_JUMP_TABLES_H
@@ -0,0 +1,27 @@
+#ifndef GAPSTONE_ANALYSIS_LINEAR_SWEEP_H
+#define GAPSTONE_ANALYSIS_LINEAR_SWEEP_H
+#include "SyclDisassembler.h"
+#include <cstdint>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace gapstone {
+
+struct SupersetView;
+
+/// linear_sweep - Marks the entries a sequential disassembler starting at
+///   entry 0, or at the start of every range of a packed decode, would
+///   visit, following offset + size after a decoded instruction and skipping
+///   step_size bytes after a failure, like objdump. The chains are found by
+///   pointer jumping, so it takes O(log n) rounds.
+///
+/// @param selected     - Device array of view.tasks flags receiving the result.
+void linear_sweep(sycl::queue &q, const SupersetView &view, uint8_t *selected);
+
+/// linear_sweep - Host wrapper returning the visited entry indices in order.
+std::vector<uint64_t> linear_sweep(sycl::queue &q,
+                                   const InstInfoContainer &insts);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_LINEAR_SWEEP_H
@@ -0,0 +1,35 @@
+#ifndef GAPSTONE_ANALYSIS_LOOP_NEST_H
+#define GAPSTONE_ANALYSIS_LOOP_NEST_H
+#include "Analysis/ControlFlow.h"
+#include "Analysis/Partition.h"
+#include <cstdint>
+#include <vector>
+
+namespace gapstone {
+
+// Dominator and loop information of every block, indexed like
+// ProgramPartition::blocks.
+struct LoopNest {
+  // Immediate dominator, NoBlock for function entries and unreachable blocks.
+  std::vector<uint64_t> idom;
+  // Innermost natural loop containing the block, named by its header, or
+  // NoBlock.
+  std::vector<uint64_t> loop_header;
+  // Number of natural loops containing the block, 0 outside loops.
+  std::vector<uint32_t> loop_depth;
+
+  static constexpr uint64_t NoBlock = ProgramPartition::NoBlock;
+};
+
+/// analyze_loop_nests - Computes dominator trees (Lengauer-Tarjan, from
+///   Boost.Graph) and natural loops of every function. Functions are handed
+///   out to a pool of host threads, each owning disjoint slices of the
+///   result arrays.
+///
+/// @param threads      - Worker count, 0 for std::thread::hardware_concurrency.
+LoopNest analyze_loop_nests(const ProgramPartition &partition,
+                            const ControlFlowGraph &cfg, unsigned threads = 0);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_LOOP_NEST_H
@@ -0,0 +1,87 @@
+#ifndef GAPSTONE_ANALYSIS_MIN_HASH_H
+#define GAPSTONE_ANALYSIS_MIN_HASH_H
+#include "Analysis/Partition.h"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <sycl/sycl.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace gapstone {
+
+struct SupersetView;
+
+// MinHash signatures of a set of functions.
+struct MinHashSignatures {
+  uint32_t num_hashes = 0;
+  // Entry address of every function.
+  std::vector<uint64_t> addresses;
+  // num_hashes values per function, function after function.
+  std::vector<uint32_t> values;
+
+  uint64_t size() const { return addresses.size(); }
+  const uint32_t *signature(uint64_t f) const {
+    return values.data() + f * num_hashes;
+  }
+};
+
+/// minhash_signatures - Shingles every function into the opcode n-grams of
+///   its basic blocks and reduces the shingles to num_hashes minima on the
+///   device. Opcodes carry no operands, so the shingles are insensitive to
+///   register allocation and addresses. An n-gram stops at the end of its
+///   block, short blocks contribute shorter shingles.
+///
+/// @param partition    - Blocks and functions of the entries of view.
+/// @param ngram        - Instructions per shingle.
+/// @param seed         - Selects the hash family; signatures are only
+///                       comparable under the same seed.
+MinHashSignatures minhash_signatures(sycl::queue &q, const SupersetView &view,
+                                     const ProgramPartition &partition,
+                                     unsigned ngram = 3,
+                                     uint32_t num_hashes = 64,
+                                     uint64_t seed = 0);
+
+/// minhash_signatures - Host wrapper.
+MinHashSignatures minhash_signatures(sycl::queue &q,
+                                     const InstInfoContainer &insts,
+                                     const ProgramPartition &partition,
+                                     unsigned ngram = 3,
+                                     uint32_t num_hashes = 64,
+                                     uint64_t seed = 0);
+
+/// estimate_similarity - Fraction of equal signature values, an estimate of
+///   the Jaccard similarity of the two shingle sets.
+float estimate_similarity(const uint32_t *a, const uint32_t *b,
+                          uint32_t num_hashes);
+
+/// write_minhash_signatures - Writes the signatures as a little-endian
+///   binary file: the magic "GSIG", a version, num_hashes and the function
+///   count, then per function its address and num_hashes 32-bit values.
+void write_minhash_signatures(std::ostream &os,
+                              const MinHashSignatures &signatures);
+
+/// read_minhash_signatures - Reads a file written by write_minhash_signatures,
+///   throws std::runtime_error if it is not one.
+MinHashSignatures read_minhash_signatures(std::istream &is);
+
+// Locality-sensitive hashing of MinHash signatures: every signature is split
+// into bands of rows values, and two functions become candidates when all
+// rows of any band agree.
+struct LSHIndex {
+  uint32_t bands = 0;
+  uint32_t rows = 0;
+  // Per band, the functions under each band hash.
+  std::vector<std::unordered_map<uint64_t, std::vector<uint64_t>>> buckets;
+
+  /// query - Indices of the functions sharing a bucket with signature,
+  ///   sorted and without duplicates.
+  std::vector<uint64_t> query(const uint32_t *signature) const;
+};
+
+/// build_lsh_index - Buckets every signature; bands must divide num_hashes.
+LSHIndex build_lsh_index(const MinHashSignatures &signatures, uint32_t bands);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_MIN_HASH_H
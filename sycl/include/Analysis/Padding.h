@@ -0,0 +1,81 @@
+#ifndef GAPSTONE_ANALYSIS_PADDING_H
+#define GAPSTONE_ANALYSIS_PADDING_H
+#include "Analysis/FunctionStarts.h"
+#include "SyclDisassembler.h"
+#include <cstdint>
+#include <llvm/TargetParser/Triple.h>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace gapstone {
+
+// Shortest run reported as padding; shorter runs of zeros are common in
+// immediates and displacements.
+constexpr uint64_t MinPaddingRun = 8;
+// The longest nop pattern of any supported target.
+constexpr uint64_t MaxNopSize = 15;
+
+namespace PaddingKind {
+enum : uint8_t {
+  Zero = 0,
+  Int3 = 1,
+  // A chain of nop instructions, see nop_patterns.
+  Nop = 2,
+};
+} // namespace PaddingKind
+
+// Byte offsets [begin, end) of one padding run.
+struct PaddingRun {
+  uint64_t begin;
+  uint64_t end;
+  uint8_t kind;
+};
+
+struct PaddingScan {
+  // Sorted by begin.
+  std::vector<PaddingRun> runs;
+  // The step-aligned offsets left to decode, increasing: every offset whose
+  // instruction is not entirely inside a run, plus the instruction starts of
+  // the nop runs so that sweeps still flow through alignment nops.
+  std::vector<uint64_t> offsets;
+};
+
+/// nop_patterns - The byte sequences the compilers of arch pad with, the
+///   longest first: the X86 nop forms up to 15 bytes, the AArch64 and
+///   LoongArch nop words. Empty for other targets.
+const std::vector<std::vector<uint8_t>> &
+nop_patterns(llvm::Triple::ArchType arch);
+
+/// scan_padding - Finds the runs of 0x00, 0xCC and nop padding at least
+///   min_run bytes long in one pass over the bytes: byte runs pair their
+///   compacted first and last bytes, nop runs are walked from the nops no
+///   other nop falls through to. The runs are marked with a scanned +1/-1
+///   difference array and the remaining offsets compacted.
+PaddingScan scan_padding(sycl::queue &q, const std::vector<uint8_t> &content,
+                         int step_size,
+                         const std::vector<std::vector<uint8_t>> &nops,
+                         uint64_t min_run = MinPaddingRun);
+
+/// clip_padding_runs - The parts of runs lying inside the ranges, split at
+///   range boundaries, so that the alignment bytes packed between ranges are
+///   not counted as padding of the binary.
+///
+/// @param ranges       - The ranges of the scanned buffer, sorted by offset.
+std::vector<PaddingRun>
+clip_padding_runs(const std::vector<PaddingRun> &runs,
+                  const std::vector<DecodeRange> &ranges);
+
+/// padding_function_hints - One FunctionHint::AfterPadding candidate per run
+///   ending on an alignment boundary before the end of its range, sorted by
+///   address.
+///
+/// @param ranges       - The ranges of the scanned buffer, sorted by offset,
+///                       see SyclDisassembler::batch_disassemble_ranges.
+std::vector<FunctionCandidate>
+padding_function_hints(const std::vector<PaddingRun> &runs,
+                       const std::vector<DecodeRange> &ranges,
+                       uint64_t alignment = 16);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_PADDING_H
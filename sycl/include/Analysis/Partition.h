@@ -0,0 +1,71 @@
+#ifndef GAPSTONE_ANALYSIS_PARTITION_H
+#define GAPSTONE_ANALYSIS_PARTITION_H
+#include "Analysis/ControlFlow.h"
+#include <cstdint>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace gapstone {
+
+struct SupersetView;
+
+struct BasicBlockInfo {
+  // [start, end) in bytes.
+  uint64_t start;
+  uint64_t end;
+  // Superset entries of the first and last instruction.
+  uint64_t first;
+  uint64_t last;
+  uint32_t num_insts;
+  uint32_t function;
+};
+
+struct FunctionInfo {
+  uint64_t entry;
+  // The blocks of the function are
+  // function_blocks[first_block] .. function_blocks[first_block + num_blocks).
+  uint64_t first_block;
+  uint64_t num_blocks;
+};
+
+struct ProgramPartition {
+  // Sorted by start address.
+  std::vector<BasicBlockInfo> blocks;
+  // Sorted by the address of their lowest block.
+  std::vector<FunctionInfo> functions;
+  // Block indices grouped by function, in address order within a function.
+  std::vector<uint64_t> function_blocks;
+  // Block of every superset entry, or NoBlock.
+  std::vector<uint64_t> block_of;
+
+  static constexpr uint64_t NoBlock = ~uint64_t(0);
+};
+
+/// partition_program - Splits the selected instructions into basic blocks and
+///   groups the blocks into functions.
+///
+///   Leaders are branch and call destinations, the fall-through successors of
+///   conditional branches and instructions nothing falls into; each block then
+///   extends along fall-through edges up to the next leader. Functions are the
+///   connected components of the intra-procedural block edges, found with a
+///   lock-free union-find on the device. Call edges, and direct branches to a
+///   call destination (tail calls), are function boundaries. A function's
+///   entry is its lowest call destination, or its lowest block if it is never
+///   called directly.
+///
+/// @param cfg          - Edges between the selected instructions.
+/// @param mask         - Device array of view.tasks flags selecting the
+///                       instructions, or nullptr for every valid entry.
+ProgramPartition partition_program(sycl::queue &q, const SupersetView &view,
+                                   const ControlFlowGraph &cfg,
+                                   const uint8_t *mask = nullptr);
+
+/// partition_program - Host wrapper; an empty mask selects every valid entry.
+ProgramPartition partition_program(sycl::queue &q,
+                                   const InstInfoContainer &insts,
+                                   const ControlFlowGraph &cfg,
+                                   const std::vector<uint8_t> &mask = {});
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_PARTITION_H
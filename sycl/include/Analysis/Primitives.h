@@ -0,0 +1,186 @@
+#ifndef GAPSTONE_ANALYSIS_PRIMITIVES_H
+#define GAPSTONE_ANALYSIS_PRIMITIVES_H
+#include <cstdint>
+#include <sycl/sycl.hpp>
+#include <utility>
+
+namespace gapstone {
+
+constexpr uint64_t ScanGroupSize = 256;
+
+/// mix64 - splitmix64 finalizer, a cheap 64-bit hash usable on the device.
+static inline uint64_t mix64(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/// exclusive_scan - Device-wide exclusive prefix sum. Each work-group scans
+///   its tile, the tile sums are scanned recursively and added back.
+///
+/// @param in           - Device array of n values, may alias out.
+/// @param out          - Device array receiving the n prefix sums.
+/// @return             - The sum of all n values.
+template <typename T>
+static T exclusive_scan(sycl::queue &q, const T *in, T *out, uint64_t n) {
+  if (n == 0)
+    return 0;
+  uint64_t groups = (n + ScanGroupSize - 1) / ScanGroupSize;
+  T *sums = sycl::malloc_device<T>(groups, q);
+  q.parallel_for(sycl::nd_range<1>(groups * ScanGroupSize, ScanGroupSize),
+                 [=](sycl::nd_item<1> item) {
+                   uint64_t i = item.get_global_id(0);
+                   T value = i < n ? in[i] : T(0);
+                   T prefix = sycl::exclusive_scan_over_group(
+                       item.get_group(), value, sycl::plus<T>());
+                   if (i < n)
+                     out[i] = prefix;
+                   if (item.get_local_id(0) == ScanGroupSize - 1)
+                     sums[item.get_group_linear_id()] = prefix + value;
+                 })
+      .wait();
+  T total;
+  if (groups == 1) {
+    q.memcpy(&total, sums, sizeof(T)).wait();
+  } else {
+    total = exclusive_scan(q, sums, sums, groups);
+    q.parallel_for(n, [=](sycl::id<1> i) {
+       out[i] += sums[i / ScanGroupSize];
+     }).wait();
+  }
+  sycl::free(sums, q);
+  return total;
+}
+
+/// compact_indices - Collects, in increasing order, the indices whose flag is
+///   set.
+///
+/// @param flags        - Device array of n flags.
+/// @param count        - Receives the number of selected indices.
+/// @return             - Device array of count indices, owned by the caller.
+static inline uint64_t *compact_indices(sycl::queue &q, const uint8_t *flags,
+                                        uint64_t n, uint64_t &count) {
+  uint64_t *positions = sycl::malloc_device<uint64_t>(n, q);
+  q.parallel_for(n, [=](sycl::id<1> i) {
+     positions[i] = flags[i] ? 1 : 0;
+   }).wait();
+  count = exclusive_scan(q, positions, positions, n);
+  uint64_t *indices = sycl::malloc_device<uint64_t>(count, q);
+  q.parallel_for(n, [=](sycl::id<1> i) {
+     if (flags[i])
+       indices[positions[i]] = i;
+   }).wait();
+  sycl::free(positions, q);
+  return indices;
+}
+
+constexpr uint64_t RadixChunkSize = 1024;
+
+/// radix_sort_pairs - Stable LSD radix sort of n keys with their values, one
+///   byte per pass and only over the bytes the largest key uses. Each pass
+///   histograms fixed-size chunks, scans the counts bucket-major and lets
+///   every chunk scatter its items in order, which keeps the sort stable.
+///
+/// @param keys         - Device array of n unsigned keys, sorted in place.
+/// @param values       - Device array of n values, permuted with the keys.
+template <typename K, typename V>
+static void radix_sort_pairs(sycl::queue &q, K *keys, V *values, uint64_t n) {
+  if (n < 2)
+    return;
+  K *max_key = sycl::malloc_shared<K>(1, q);
+  *max_key = 0;
+  q.parallel_for(n, [=](sycl::id<1> i) {
+     sycl::atomic_ref<K, sycl::memory_order::relaxed,
+                      sycl::memory_scope::device>
+         ref(*max_key);
+     ref.fetch_max(keys[i]);
+   }).wait();
+  unsigned passes = 0;
+  for (K k = *max_key; k; k >>= 8)
+    ++passes;
+  sycl::free(max_key, q);
+
+  uint64_t chunks = (n + RadixChunkSize - 1) / RadixChunkSize;
+  uint64_t *counts = sycl::malloc_device<uint64_t>(256 * chunks, q);
+  K *keys_tmp = sycl::malloc_device<K>(n, q);
+  V *values_tmp = sycl::malloc_device<V>(n, q);
+  K *keys_in = keys, *keys_out = keys_tmp;
+  V *values_in = values, *values_out = values_tmp;
+  for (unsigned pass = 0; pass < passes; ++pass) {
+    unsigned shift = pass * 8;
+    q.parallel_for(chunks, [=](sycl::id<1> c) {
+       uint64_t hist[256] = {};
+       uint64_t end = (c + 1) * RadixChunkSize < n ? (c + 1) * RadixChunkSize
+                                                   : n;
+       for (uint64_t i = c * RadixChunkSize; i < end; ++i)
+         ++hist[(keys_in[i] >> shift) & 0xff];
+       for (unsigned b = 0; b < 256; ++b)
+         counts[b * chunks + c] = hist[b];
+     }).wait();
+    exclusive_scan(q, counts, counts, 256 * chunks);
+    q.parallel_for(chunks, [=](sycl::id<1> c) {
+       uint64_t offset[256];
+       for (unsigned b = 0; b < 256; ++b)
+         offset[b] = counts[b * chunks + c];
+       uint64_t end = (c + 1) * RadixChunkSize < n ? (c + 1) * RadixChunkSize
+                                                   : n;
+       for (uint64_t i = c * RadixChunkSize; i < end; ++i) {
+         uint64_t dst = offset[(keys_in[i] >> shift) & 0xff]++;
+         keys_out[dst] = keys_in[i];
+         values_out[dst] = values_in[i];
+       }
+     }).wait();
+    std::swap(keys_in, keys_out);
+    std::swap(values_in, values_out);
+  }
+  if (keys_in != keys) {
+    q.memcpy(keys, keys_in, n * sizeof(K));
+    q.memcpy(values, values_in, n * sizeof(V));
+    q.wait();
+  }
+  sycl::free(values_tmp, q);
+  sycl::free(keys_tmp, q);
+  sycl::free(counts, q);
+}
+
+/// union_find_root - Root of x in a device-wide union-find forest.
+static inline uint64_t union_find_root(uint64_t *parent, uint64_t x) {
+  while (true) {
+    sycl::atomic_ref<uint64_t, sycl::memory_order::relaxed,
+                     sycl::memory_scope::device>
+        p(parent[x]);
+    uint64_t up = p.load();
+    if (up == x)
+      return x;
+    x = up;
+  }
+}
+
+/// union_find_unite - Merges the sets of a and b from any number of work-items
+///   at once. The larger root is hooked below the smaller one, so every root
+///   is the smallest element of its set.
+static inline void union_find_unite(uint64_t *parent, uint64_t a, uint64_t b) {
+  while (true) {
+    a = union_find_root(parent, a);
+    b = union_find_root(parent, b);
+    if (a == b)
+      return;
+    if (a < b) {
+      uint64_t t = a;
+      a = b;
+      b = t;
+    }
+    sycl::atomic_ref<uint64_t, sycl::memory_order::relaxed,
+                     sycl::memory_scope::device>
+        p(parent[a]);
+    uint64_t expected = a;
+    if (p.compare_exchange_strong(expected, b))
+      return;
+  }
+}
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_PRIMITIVES_H
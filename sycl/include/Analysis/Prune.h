@@ -0,0 +1,29 @@
+#ifndef GAPSTONE_ANALYSIS_PRUNE_H
+#define GAPSTONE_ANALYSIS_PRUNE_H
+#include "SyclDisassembler.h"
+#include <cstdint>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace gapstone {
+
+struct SupersetView;
+
+/// prune_invalid_chains - Keeps the entries whose fall-through chain reaches
+///   an unconditional terminator (return or barrier). A chain that runs into
+///   a decode failure, off the end of the section, or through a direct branch
+///   to an undecodable offset of the section cannot be real code. The
+///   verdicts propagate backward along offset + size links by pointer
+///   jumping.
+///
+/// @param keep         - Device array of view.tasks flags receiving the mask.
+void prune_invalid_chains(sycl::queue &q, const SupersetView &view,
+                          uint8_t *keep);
+
+/// prune_invalid_chains - Host wrapper returning the mask.
+std::vector<uint8_t> prune_invalid_chains(sycl::queue &q,
+                                          const InstInfoContainer &insts);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_PRUNE_H
@@ -0,0 +1,79 @@
+#ifndef GAPSTONE_ANALYSIS_SAMPLING_H
+#define GAPSTONE_ANALYSIS_SAMPLING_H
+#include "SyclDisassembler.h"
+#include <cstdint>
+#include <vector>
+
+namespace gapstone {
+
+enum class SampleMode {
+  // Offsets drawn uniformly without replacement.
+  Random,
+  // One offset drawn uniformly from each of equally sized strata, which
+  // spreads the sample over the whole blob.
+  Stratified,
+};
+
+// Estimated share with its confidence interval.
+struct Proportion {
+  double estimate = 0.0;
+  double low = 0.0;
+  double high = 1.0;
+  uint64_t trials = 0;
+};
+
+struct OpcodeShare {
+  uint16_t opcode;
+  // Share of the decoded samples.
+  Proportion share;
+};
+
+struct SampleEstimate {
+  uint64_t samples = 0;
+  // Share of the sampled offsets that decode.
+  Proportion decodes;
+  // Share of the sampled offsets that start a run of chain instructions
+  // which all decode, or decode up to a return or barrier. Data rarely
+  // survives more than a couple of instructions, so this estimates the code
+  // ratio.
+  Proportion code;
+  // Share of the decoded direct branches and calls whose target decodes.
+  Proportion branch_consistency;
+  // The most frequent opcodes of the decoded samples, most frequent first.
+  std::vector<OpcodeShare> opcode_mix;
+};
+
+/// wilson_interval - Wilson score interval of hits out of trials, which
+///   stays inside [0, 1] and behaves for shares near 0 or 1 and for small
+///   samples. Stratified samples vary less than random ones, so the interval
+///   is conservative for them.
+///
+/// @param z            - Standard normal quantile, 1.96 for 95%.
+Proportion wilson_interval(uint64_t hits, uint64_t trials, double z = 1.96);
+
+/// sample_offsets - Draws rate of the step_size-aligned offsets below size,
+///   at least one, in increasing order.
+///
+/// @param seed         - Seed of the generator, the same seed draws the same
+///                       offsets.
+std::vector<uint64_t> sample_offsets(uint64_t size, int step_size, double rate,
+                                     SampleMode mode, uint64_t seed = 0);
+
+/// estimate_from_sample - Decodes the sampled offsets and the instructions
+///   following them, chain - 1 batches of at most offsets.size() entries,
+///   plus one batch for the branch targets, and estimates the properties of
+///   the whole blob.
+///
+/// @param offsets      - Sampled offsets into content, see sample_offsets.
+/// @param chain        - Instructions that must decode from a sample for it
+///                       to count as code.
+/// @param top          - Number of opcodes in the opcode mix.
+SampleEstimate estimate_from_sample(SyclDisassembler &disassembler,
+                                    uint64_t base_addr,
+                                    std::vector<uint8_t> &content,
+                                    const std::vector<uint64_t> &offsets,
+                                    unsigned chain = 4, unsigned top = 8);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_SAMPLING_H
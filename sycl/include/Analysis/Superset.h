@@ -0,0 +1,118 @@
+#ifndef GAPSTONE_ANALYSIS_SUPERSET_H
+#define GAPSTONE_ANALYSIS_SUPERSET_H
+#include "InstAttributes.h"
+#include "SyclDisassembler.h"
+#include <sycl/sycl.hpp>
+
+namespace gapstone {
+
+// Kernel-side view of superset decode results. Entry i describes the offset
+// i * step_size, the index tasks is used as the "no instruction" sentinel.
+// With ranges, the offsets are those of a packed buffer, see
+// SyclDisassembler::batch_disassemble_ranges.
+struct SupersetView {
+  const llvm::MCDisassembler::DecodeStatus *status;
+  const uint8_t *sizes;
+  const uint16_t *attributes;
+  const uint64_t *targets;
+  const uint8_t *target_kinds;
+  const uint16_t *opcodes;
+  uint64_t tasks;
+  uint64_t base_addr;
+  int step_size;
+  const DecodeRange *ranges;
+  uint64_t num_ranges;
+
+  bool valid(uint64_t i) const {
+    return status[i] != llvm::MCDisassembler::Fail;
+  }
+  uint64_t address(uint64_t i) const {
+    return range_address(ranges, num_ranges, base_addr, i * step_size);
+  }
+  // Index of the decode entry at Address, or tasks if it has none.
+  uint64_t index_of(uint64_t Address) const {
+    return entry_at(range_offset(ranges, num_ranges, base_addr, Address));
+  }
+  // Whether entry i is the first of its range, where sequential decoding
+  // starts.
+  bool starts_range(uint64_t i) const {
+    if (num_ranges == 0)
+      return i == 0;
+    return ranges[range_at(ranges, num_ranges, i * step_size)].offset ==
+           i * step_size;
+  }
+  // Index of the fall-through successor of a valid entry, or tasks. Flow
+  // only continues into another range loaded right after.
+  uint64_t next(uint64_t i) const {
+    uint64_t offset = i * step_size + sizes[i];
+    if (sizes[i] == 0 || offset % step_size)
+      return tasks;
+    uint64_t j = offset / step_size;
+    if (j >= tasks || (num_ranges && address(j) != address(i) + sizes[i]))
+      return tasks;
+    return j;
+  }
+  // Whether execution never continues to the next instruction.
+  bool ends_flow(uint64_t i) const {
+    return attributes[i] & (InstAttr::Barrier | InstAttr::Return);
+  }
+  // Whether the valid entry i jumps to a register or memory operand.
+  bool indirect_jump(uint64_t i) const {
+    uint16_t attrs = attributes[i];
+    return (attrs & InstAttr::Branch) && (attrs & InstAttr::Indirect) &&
+           !(attrs & (InstAttr::Call | InstAttr::Return));
+  }
+  // Index of the direct branch or call destination, or tasks. Where ranges
+  // overlap, as the sections of a relocatable object do, the range of the
+  // branch itself is tried first.
+  uint64_t branch_target(uint64_t i) const {
+    if (target_kinds[i] != TargetKind::Branch &&
+        target_kinds[i] != TargetKind::Call)
+      return tasks;
+    if (num_ranges) {
+      const DecodeRange &range =
+          ranges[range_at(ranges, num_ranges, i * step_size)];
+      if (targets[i] >= range.address &&
+          targets[i] - range.address < range.size)
+        return entry_at(range.offset + (targets[i] - range.address));
+    }
+    return index_of(targets[i]);
+  }
+  // Index of the entry at a byte offset, or tasks.
+  uint64_t entry_at(uint64_t offset) const {
+    if (offset == NoOffset || offset % step_size)
+      return tasks;
+    uint64_t i = offset / step_size;
+    return i < tasks ? i : tasks;
+  }
+};
+
+/// host_view - SupersetView over the host arrays of insts, for host passes
+///   that share the device helpers.
+static inline SupersetView host_view(const InstInfoContainer &insts) {
+  return {insts.status.data(),  insts.sizes.data(),
+          insts.attributes.data(), insts.targets.data(),
+          insts.target_kinds.data(), insts.opcodes.data(),
+          insts.status.size(),
+          insts.base_addr,       insts.step_size,
+          insts.ranges.data(),   insts.ranges.size()};
+}
+
+// Device-resident copy of an InstInfoContainer, shared by the analysis passes.
+class DeviceSuperset {
+  sycl::queue &q;
+  SupersetView View;
+
+public:
+  DeviceSuperset(sycl::queue &qq, const InstInfoContainer &insts);
+  DeviceSuperset(const DeviceSuperset &) = delete;
+  DeviceSuperset &operator=(const DeviceSuperset &) = delete;
+  ~DeviceSuperset();
+
+  const SupersetView &view() const { return View; }
+  uint64_t tasks() const { return View.tasks; }
+};
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_SUPERSET_H
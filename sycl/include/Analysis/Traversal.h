@@ -0,0 +1,31 @@
+#ifndef GAPSTONE_ANALYSIS_TRAVERSAL_H
+#define GAPSTONE_ANALYSIS_TRAVERSAL_H
+#include "SyclDisassembler.h"
+#include <cstdint>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace gapstone {
+
+struct SupersetView;
+
+/// recursive_traversal - Marks every entry reachable from the seeds over
+///   fall-through and direct branch and call edges. Runs as a level-synchronous
+///   BFS, each frontier expanded by one kernel.
+///
+/// @param seeds        - Device array of seed_count entry indices; indices
+///                       out of range or of undecodable entries are ignored.
+/// @param reached      - Device array of view.tasks flags receiving the result.
+void recursive_traversal(sycl::queue &q, const SupersetView &view,
+                         const uint64_t *seeds, uint64_t seed_count,
+                         uint8_t *reached);
+
+/// recursive_traversal - Host wrapper taking entry addresses and returning
+///   the reachable entry indices in increasing order.
+std::vector<uint64_t>
+recursive_traversal(sycl::queue &q, const InstInfoContainer &insts,
+                    const std::vector<uint64_t> &entry_addresses);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_TRAVERSAL_H
@@ -0,0 +1,48 @@
+#ifndef GAPSTONE_ANALYSIS_XREF_H
+#define GAPSTONE_ANALYSIS_XREF_H
+#include "SyclDisassembler.h"
+#include <algorithm>
+#include <cstdint>
+#include <sycl/sycl.hpp>
+#include <utility>
+#include <vector>
+
+namespace gapstone {
+
+struct SupersetView;
+
+// Address references sorted by target. Entry k says that the instruction at
+// sources[k] refers to targets[k], kinds[k] being its TargetKind.
+struct XrefIndex {
+  std::vector<uint64_t> targets;
+  std::vector<uint64_t> sources;
+  std::vector<uint8_t> kinds;
+
+  /// find - Range [first, last) of the references to Address, by binary
+  ///   search.
+  std::pair<uint64_t, uint64_t> find(uint64_t Address) const {
+    auto range = std::equal_range(targets.begin(), targets.end(), Address);
+    return {range.first - targets.begin(), range.second - targets.begin()};
+  }
+};
+
+/// build_xref_index - Collects the branch, call, PC-relative memory and page
+///   references and the move-immediates that fall in [imm_low, imm_high) of
+///   every selected entry, then radix-sorts them by target on the device.
+///
+/// @param mask         - Device array of view.tasks flags selecting the
+///                       referrers, or nullptr for every valid entry.
+/// @param imm_low      - Immediates outside [imm_low, imm_high) are constants
+///                       rather than addresses and are left out.
+XrefIndex build_xref_index(sycl::queue &q, const SupersetView &view,
+                           const uint8_t *mask, uint64_t imm_low,
+                           uint64_t imm_high);
+
+/// build_xref_index - Host wrapper; an empty mask selects every valid entry.
+XrefIndex build_xref_index(sycl::queue &q, const InstInfoContainer &insts,
+                           const std::vector<uint8_t> &mask, uint64_t imm_low,
+                           uint64_t imm_high);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_ANALYSIS_XREF_H
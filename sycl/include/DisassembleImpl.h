@@ -1,6 +1,7 @@
 #ifndef GAPSTONE_DISASSEMBLE_IMPL_H
 #define GAPSTONE_DISASSEMBLE_IMPL_H
 #include "SyclDisassembler.h"
+#include <algorithm>
 #include <memory>
 #include <sycl/sycl.hpp>
 // template<typename T>
@@ -34,6 +35,141 @@
 //   return res;
 // }
 
+// The immediate a move-immediate instruction without a PC-relative target
+// loads, as a TargetKind::Immediate target.
+template <typename T>
+static uint8_t get_immediate_target(const T &MI, uint16_t Attributes,
+                                    uint64_t &Target) {
+  int Imm = gapstone::getImmediateOperand(MI);
+  if (!(Attributes & gapstone::InstAttr::MoveImmediate) || Imm < 0)
+    return gapstone::TargetKind::None;
+  Target = MI.getOperand(Imm).getImm();
+  return gapstone::TargetKind::Immediate;
+}
+
+// Decodes the instruction at offset into entry i of the result arrays.
+template <typename T>
+static void decode_entry(T *gpu_insts, DecodeStatus *status, uint8_t *sizes,
+                         uint16_t *attributes, uint64_t *targets,
+                         uint8_t *target_kinds, uint16_t *opcodes, uint64_t i,
+                         const uint8_t *device_content, uint64_t buffer_size,
+                         uint64_t offset, uint64_t base_addr,
+                         const FeatureBitset &Bits) {
+  llvm::ArrayRef<uint8_t> array_ref(device_content + offset,
+                                    buffer_size - offset);
+  status[i] = disassemble_instruction(gpu_insts[i], array_ref,
+                                      base_addr + offset, Bits);
+  targets[i] = 0;
+  if (status[i] == MCDisassembler::Fail) {
+    sizes[i] = 0;
+    attributes[i] = gapstone::InstAttr::None;
+    target_kinds[i] = gapstone::TargetKind::None;
+    opcodes[i] = 0;
+    return;
+  }
+  sizes[i] = gpu_insts[i].Size;
+  opcodes[i] = gpu_insts[i].getOpcode();
+  attributes[i] =
+      gapstone::getInstAttributes(getMCID(gpu_insts[i].getOpcode()));
+  target_kinds[i] = get_target(gpu_insts[i], base_addr + offset, targets[i]);
+  if (target_kinds[i] == gapstone::TargetKind::None)
+    target_kinds[i] =
+        get_immediate_target(gpu_insts[i], attributes[i], targets[i]);
+}
+
+// Marks entry i as not decoded.
+static void skip_entry(DecodeStatus *status, uint8_t *sizes,
+                       uint16_t *attributes, uint64_t *targets,
+                       uint8_t *target_kinds, uint16_t *opcodes, uint64_t i) {
+  status[i] = MCDisassembler::Fail;
+  sizes[i] = 0;
+  attributes[i] = gapstone::InstAttr::None;
+  targets[i] = 0;
+  target_kinds[i] = gapstone::TargetKind::None;
+  opcodes[i] = 0;
+}
+
+// Decodes every step-aligned offset of content, or only the given ones, in
+// one launch, each entry finding its range in the table and decoding up to
+// the end of it. Entries outside every range, or not selected, read as
+// failed decodes; those are all zero, so the arrays start zeroed.
+template <typename T>
+static std::unique_ptr<gapstone::InstInfoContainer>
+disassemble_ranges_impl(sycl::queue &q, llvm::MCDisassembler &MCDisassembler,
+                        std::vector<uint8_t> &content,
+                        const std::vector<gapstone::DecodeRange> &ranges,
+                        int step_size,
+                        const std::vector<uint64_t> *offsets = nullptr) {
+  auto tasks = content.size() / step_size;
+  auto res = std::make_unique<gapstone::InstInfoContainerGPU<T>>(tasks);
+  res->base_addr = ranges.empty() ? 0 : ranges[0].address;
+  res->step_size = step_size;
+  res->ranges = ranges;
+  uint64_t num_ranges = ranges.size();
+  uint64_t launched = offsets ? offsets->size() : tasks;
+  if (tasks == 0 || num_ranges == 0 || launched == 0)
+    return res;
+  const FeatureBitset &Bits =
+      MCDisassembler.getSubtargetInfo().getFeatureBits();
+  T *gpu_insts = sycl::malloc_shared<T>(tasks, q);
+  DecodeStatus *status = sycl::malloc_shared<DecodeStatus>(tasks, q);
+  uint8_t *sizes = sycl::malloc_shared<uint8_t>(tasks, q);
+  uint16_t *attributes = sycl::malloc_shared<uint16_t>(tasks, q);
+  uint64_t *targets = sycl::malloc_shared<uint64_t>(tasks, q);
+  uint8_t *target_kinds = sycl::malloc_shared<uint8_t>(tasks, q);
+  uint16_t *opcodes = sycl::malloc_shared<uint16_t>(tasks, q);
+  gapstone::DecodeRange *device_ranges =
+      sycl::malloc_device<gapstone::DecodeRange>(num_ranges, q);
+  uint64_t *device_offsets =
+      offsets ? sycl::malloc_device<uint64_t>(launched, q) : nullptr;
+  uint8_t *device_content = sycl::malloc_device<uint8_t>(content.size(), q);
+  q.memset(status, 0, tasks * sizeof(DecodeStatus));
+  q.memset(sizes, 0, tasks * sizeof(uint8_t));
+  q.memset(attributes, 0, tasks * sizeof(uint16_t));
+  q.memset(targets, 0, tasks * sizeof(uint64_t));
+  q.memset(target_kinds, 0, tasks * sizeof(uint8_t));
+  q.memset(opcodes, 0, tasks * sizeof(uint16_t));
+  q.memcpy(device_ranges, ranges.data(),
+           num_ranges * sizeof(gapstone::DecodeRange));
+  if (offsets)
+    q.memcpy(device_offsets, offsets->data(), launched * sizeof(uint64_t));
+  q.memcpy(device_content, content.data(), content.size());
+  q.wait();
+  q.parallel_for(launched, [=](sycl::id<1> k) {
+     uint64_t offset = device_offsets ? device_offsets[k] : k * step_size;
+     uint64_t i = offset / step_size;
+     if (i >= tasks)
+       return;
+     gapstone::DecodeRange range =
+         device_ranges[gapstone::range_at(device_ranges, num_ranges, offset)];
+     if (offset < range.offset || offset - range.offset >= range.size)
+       return;
+     decode_entry(gpu_insts, status, sizes, attributes, targets, target_kinds,
+                  opcodes, i, device_content + range.offset, range.size,
+                  offset - range.offset, range.address, Bits);
+   }).wait();
+  q.memcpy(res->status.data(), status, tasks * sizeof(DecodeStatus));
+  q.memcpy(res->sizes.data(), sizes, tasks * sizeof(uint8_t));
+  q.memcpy(res->attributes.data(), attributes, tasks * sizeof(uint16_t));
+  q.memcpy(res->targets.data(), targets, tasks * sizeof(uint64_t));
+  q.memcpy(res->target_kinds.data(), target_kinds, tasks * sizeof(uint8_t));
+  q.memcpy(res->opcodes.data(), opcodes, tasks * sizeof(uint16_t));
+  q.memcpy(res->insts.data(), gpu_insts, tasks * sizeof(T));
+  q.wait();
+  sycl::free(status, q);
+  sycl::free(sizes, q);
+  sycl::free(attributes, q);
+  sycl::free(targets, q);
+  sycl::free(target_kinds, q);
+  sycl::free(opcodes, q);
+  sycl::free(gpu_insts, q);
+  sycl::free(device_content, q);
+  if (device_offsets)
+    sycl::free(device_offsets, q);
+  sycl::free(device_ranges, q);
+  return res;
+}
+
 template <typename T>
 static std::unique_ptr<gapstone::InstInfoContainer>
 disassemble_impl(sycl::queue &q, llvm::MCDisassembler &MCDisassembler,
@@ -45,26 +181,197 @@ disassemble_impl(sycl::queue &q, llvm::MCDisassembler &MCDisassembler,
   auto buffer_size = content.size();
   T *gpu_insts = sycl::malloc_shared<T>(tasks, q);
   DecodeStatus *status = sycl::malloc_shared<DecodeStatus>(tasks, q);
+  uint8_t *sizes = sycl::malloc_shared<uint8_t>(tasks, q);
+  uint16_t *attributes = sycl::malloc_shared<uint16_t>(tasks, q);
+  uint64_t *targets = sycl::malloc_shared<uint64_t>(tasks, q);
+  uint8_t *target_kinds = sycl::malloc_shared<uint8_t>(tasks, q);
+  uint16_t *opcodes = sycl::malloc_shared<uint16_t>(tasks, q);
   uint8_t *device_content = sycl::malloc_device<uint8_t>(content.size(), q);
   auto event_copy = q.memcpy(device_content, content.data(), content.size());
   auto event_disassemble = q.submit([&](sycl::handler &h) {
     h.depends_on(event_copy);
     h.parallel_for(tasks, [=](sycl::id<1> i) {
-      uint64_t offset = i * step_size;
-      llvm::ArrayRef<uint8_t> array_ref(device_content + offset,
-                                        buffer_size - offset);
-      status[i] = disassemble_instruction(gpu_insts[i], array_ref,
-                                          base_addr + offset, Bits);
+      decode_entry(gpu_insts, status, sizes, attributes, targets, target_kinds,
+                   opcodes, i, device_content, buffer_size, i * step_size,
+                   base_addr, Bits);
     });
   });
   event_disassemble.wait();
   auto res = std::make_unique<gapstone::InstInfoContainerGPU<T>>(tasks);
+  res->base_addr = base_addr;
+  res->step_size = step_size;
+  q.memcpy(res->status.data(), status, tasks * sizeof(DecodeStatus));
+  q.memcpy(res->sizes.data(), sizes, tasks * sizeof(uint8_t));
+  q.memcpy(res->attributes.data(), attributes, tasks * sizeof(uint16_t));
+  q.memcpy(res->targets.data(), targets, tasks * sizeof(uint64_t));
+  q.memcpy(res->target_kinds.data(), target_kinds, tasks * sizeof(uint8_t));
+  q.memcpy(res->opcodes.data(), opcodes, tasks * sizeof(uint16_t));
+  q.memcpy(res->insts.data(), gpu_insts, tasks * sizeof(T));
+  q.wait();
+  sycl::free(status, q);
+  sycl::free(sizes, q);
+  sycl::free(attributes, q);
+  sycl::free(targets, q);
+  sycl::free(target_kinds, q);
+  sycl::free(opcodes, q);
+  sycl::free(gpu_insts, q);
+  sycl::free(device_content, q);
+  return res;
+}
+
+// Decodes only the given step-aligned offsets into a result with the layout
+// of disassemble_impl; the other entries read as failed decodes. Failed
+// entries are all zero, so the arrays start zeroed.
+template <typename T>
+static std::unique_ptr<gapstone::InstInfoContainer>
+disassemble_selected_impl(sycl::queue &q,
+                          llvm::MCDisassembler &MCDisassembler,
+                          uint64_t base_addr, std::vector<uint8_t> &content,
+                          int step_size, const std::vector<uint64_t> &offsets) {
+  auto tasks = content.size() / step_size;
+  auto selected = offsets.size();
+  const FeatureBitset &Bits =
+      MCDisassembler.getSubtargetInfo().getFeatureBits();
+  auto buffer_size = content.size();
+  T *gpu_insts = sycl::malloc_shared<T>(tasks, q);
+  DecodeStatus *status = sycl::malloc_shared<DecodeStatus>(tasks, q);
+  uint8_t *sizes = sycl::malloc_shared<uint8_t>(tasks, q);
+  uint16_t *attributes = sycl::malloc_shared<uint16_t>(tasks, q);
+  uint64_t *targets = sycl::malloc_shared<uint64_t>(tasks, q);
+  uint8_t *target_kinds = sycl::malloc_shared<uint8_t>(tasks, q);
+  uint16_t *opcodes = sycl::malloc_shared<uint16_t>(tasks, q);
+  uint64_t *device_offsets = sycl::malloc_device<uint64_t>(selected + 1, q);
+  uint8_t *device_content = sycl::malloc_device<uint8_t>(content.size(), q);
+  q.memset(status, 0, tasks * sizeof(DecodeStatus));
+  q.memset(sizes, 0, tasks * sizeof(uint8_t));
+  q.memset(attributes, 0, tasks * sizeof(uint16_t));
+  q.memset(targets, 0, tasks * sizeof(uint64_t));
+  q.memset(target_kinds, 0, tasks * sizeof(uint8_t));
+  q.memset(opcodes, 0, tasks * sizeof(uint16_t));
+  q.memcpy(device_offsets, offsets.data(), selected * sizeof(uint64_t));
+  q.memcpy(device_content, content.data(), content.size());
+  q.wait();
+  if (selected) {
+    q.parallel_for(selected, [=](sycl::id<1> k) {
+       uint64_t offset = device_offsets[k];
+       uint64_t i = offset / step_size;
+       if (i >= tasks)
+         return;
+       decode_entry(gpu_insts, status, sizes, attributes, targets,
+                    target_kinds, opcodes, i, device_content, buffer_size,
+                    offset, base_addr, Bits);
+     }).wait();
+  }
+  auto res = std::make_unique<gapstone::InstInfoContainerGPU<T>>(tasks);
+  res->base_addr = base_addr;
+  res->step_size = step_size;
+  q.memcpy(res->status.data(), status, tasks * sizeof(DecodeStatus));
+  q.memcpy(res->sizes.data(), sizes, tasks * sizeof(uint8_t));
+  q.memcpy(res->attributes.data(), attributes, tasks * sizeof(uint16_t));
+  q.memcpy(res->targets.data(), targets, tasks * sizeof(uint64_t));
+  q.memcpy(res->target_kinds.data(), target_kinds, tasks * sizeof(uint8_t));
+  q.memcpy(res->opcodes.data(), opcodes, tasks * sizeof(uint16_t));
+  q.memcpy(res->insts.data(), gpu_insts, tasks * sizeof(T));
+  q.wait();
+  sycl::free(status, q);
+  sycl::free(sizes, q);
+  sycl::free(attributes, q);
+  sycl::free(targets, q);
+  sycl::free(target_kinds, q);
+  sycl::free(opcodes, q);
+  sycl::free(gpu_insts, q);
+  sycl::free(device_content, q);
+  sycl::free(device_offsets, q);
+  return res;
+}
+
+// Bytes uploaded per offset by disassemble_offsets_impl, enough for the
+// longest instruction of any supported target.
+constexpr uint64_t OffsetWindow = 32;
+
+// Decodes only the given byte offsets; entry k describes offsets[k]. Offsets
+// past the end of content fail to decode. When the offsets are sparse only
+// the OffsetWindow bytes from each are uploaded, packed one after the other.
+template <typename T>
+static std::unique_ptr<gapstone::InstInfoContainer>
+disassemble_offsets_impl(sycl::queue &q, llvm::MCDisassembler &MCDisassembler,
+                         uint64_t base_addr, std::vector<uint8_t> &content,
+                         const std::vector<uint64_t> &offsets) {
+  auto tasks = offsets.size();
+  auto res = std::make_unique<gapstone::InstInfoContainerGPU<T>>(tasks);
+  res->base_addr = base_addr;
+  res->step_size = 1;
+  if (tasks == 0)
+    return res;
+  const FeatureBitset &Bits =
+      MCDisassembler.getSubtargetInfo().getFeatureBits();
+  auto buffer_size = content.size();
+  T *gpu_insts = sycl::malloc_shared<T>(tasks, q);
+  DecodeStatus *status = sycl::malloc_shared<DecodeStatus>(tasks, q);
+  uint8_t *sizes = sycl::malloc_shared<uint8_t>(tasks, q);
+  uint16_t *attributes = sycl::malloc_shared<uint16_t>(tasks, q);
+  uint64_t *targets = sycl::malloc_shared<uint64_t>(tasks, q);
+  uint8_t *target_kinds = sycl::malloc_shared<uint8_t>(tasks, q);
+  uint16_t *opcodes = sycl::malloc_shared<uint16_t>(tasks, q);
+  bool windowed = tasks * OffsetWindow < buffer_size;
+  uint64_t upload_size = windowed ? tasks * OffsetWindow : buffer_size;
+  std::vector<uint8_t> windows;
+  if (windowed) {
+    windows.resize(upload_size);
+    for (uint64_t k = 0; k < tasks; ++k) {
+      if (offsets[k] >= buffer_size)
+        continue;
+      uint64_t length = std::min(OffsetWindow, buffer_size - offsets[k]);
+      std::copy_n(content.begin() + offsets[k], length,
+                  windows.begin() + k * OffsetWindow);
+    }
+  }
+  uint64_t *device_offsets = sycl::malloc_device<uint64_t>(tasks, q);
+  uint8_t *device_content = sycl::malloc_device<uint8_t>(upload_size, q);
+  q.memcpy(device_offsets, offsets.data(), tasks * sizeof(uint64_t));
+  auto event_copy =
+      q.memcpy(device_content, windowed ? windows.data() : content.data(),
+               upload_size);
+  auto event_disassemble = q.submit([&](sycl::handler &h) {
+    h.depends_on(event_copy);
+    h.parallel_for(tasks, [=](sycl::id<1> i) {
+      uint64_t offset = device_offsets[i];
+      if (offset >= buffer_size) {
+        skip_entry(status, sizes, attributes, targets, target_kinds, opcodes,
+                   i);
+        return;
+      }
+      if (!windowed) {
+        decode_entry(gpu_insts, status, sizes, attributes, targets,
+                     target_kinds, opcodes, i, device_content, buffer_size,
+                     offset, base_addr, Bits);
+        return;
+      }
+      // The window of entry i starts at offset.
+      uint64_t length = sycl::min(OffsetWindow, buffer_size - offset);
+      decode_entry(gpu_insts, status, sizes, attributes, targets, target_kinds,
+                   opcodes, i, device_content + i * OffsetWindow, length, 0,
+                   base_addr + offset, Bits);
+    });
+  });
+  event_disassemble.wait();
   q.memcpy(res->status.data(), status, tasks * sizeof(DecodeStatus));
+  q.memcpy(res->sizes.data(), sizes, tasks * sizeof(uint8_t));
+  q.memcpy(res->attributes.data(), attributes, tasks * sizeof(uint16_t));
+  q.memcpy(res->targets.data(), targets, tasks * sizeof(uint64_t));
+  q.memcpy(res->target_kinds.data(), target_kinds, tasks * sizeof(uint8_t));
+  q.memcpy(res->opcodes.data(), opcodes, tasks * sizeof(uint16_t));
   q.memcpy(res->insts.data(), gpu_insts, tasks * sizeof(T));
   q.wait();
   sycl::free(status, q);
+  sycl::free(sizes, q);
+  sycl::free(attributes, q);
+  sycl::free(targets, q);
+  sycl::free(target_kinds, q);
+  sycl::free(opcodes, q);
   sycl::free(gpu_insts, q);
   sycl::free(device_content, q);
+  sycl::free(device_offsets, q);
   return res;
 }
 
@@ -78,6 +385,9 @@ decode_impl(sycl::queue &q, llvm::MCDisassembler &MCDisassembler,
   auto buffer_size = content.size();
   T *gpu_insts = sycl::malloc_shared<T>(tasks, q);
   DecodeStatus *status = sycl::malloc_shared<DecodeStatus>(tasks, q);
+  uint16_t *attributes = sycl::malloc_shared<uint16_t>(tasks, q);
+  uint64_t *targets = sycl::malloc_shared<uint64_t>(tasks, q);
+  uint8_t *target_kinds = sycl::malloc_shared<uint8_t>(tasks, q);
   uint8_t *device_content = sycl::malloc_device<uint8_t>(content.size(), q);
   auto event_copy = q.memcpy(device_content, content.data(), content.size());
   auto event_disassemble = q.submit([&](sycl::handler &h) {
@@ -116,11 +426,41 @@ decode_impl(sycl::queue &q, llvm::MCDisassembler &MCDisassembler,
       break;
     }
   }
+  // The opcode and operands are only final after decodeToMCInst, so the
+  // attributes and targets are derived in a second launch.
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     targets[i] = 0;
+     if (status[i] == MCDisassembler::Fail) {
+       attributes[i] = gapstone::InstAttr::None;
+       target_kinds[i] = gapstone::TargetKind::None;
+       return;
+     }
+     attributes[i] =
+         gapstone::getInstAttributes(getMCID(gpu_insts[i].getOpcode()));
+     target_kinds[i] = get_target(gpu_insts[i], base_addr + i * step_size,
+                                  Bits, targets[i]);
+     if (target_kinds[i] == gapstone::TargetKind::None)
+       target_kinds[i] =
+           get_immediate_target(gpu_insts[i], attributes[i], targets[i]);
+   }).wait();
   auto res = std::make_unique<gapstone::InstInfoContainerGPU<T>>(tasks);
+  res->base_addr = base_addr;
+  res->step_size = step_size;
   q.memcpy(res->status.data(), status, tasks * sizeof(DecodeStatus));
+  q.memcpy(res->attributes.data(), attributes, tasks * sizeof(uint16_t));
+  q.memcpy(res->targets.data(), targets, tasks * sizeof(uint64_t));
+  q.memcpy(res->target_kinds.data(), target_kinds, tasks * sizeof(uint8_t));
   q.memcpy(res->insts.data(), gpu_insts, tasks * sizeof(T));
   q.wait();
+  for (int i = 0; i < tasks; ++i) {
+    bool Decoded = res->status[i] != MCDisassembler::Fail;
+    res->sizes[i] = Decoded ? res->insts[i].Size : 0;
+    res->opcodes[i] = Decoded ? res->insts[i].getOpcode() : 0;
+  }
   sycl::free(status, q);
+  sycl::free(attributes, q);
+  sycl::free(targets, q);
+  sycl::free(target_kinds, q);
   sycl::free(gpu_insts, q);
   sycl::free(device_content, q);
   return res;
@@ -0,0 +1,59 @@
+#ifndef GAPSTONE_IDENTIFY_H
+#define GAPSTONE_IDENTIFY_H
+#include "Analysis/Sampling.h"
+#include <cstdint>
+#include <string>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace gapstone {
+
+// A backend, mode and byte order a blob may have been built for.
+struct ArchCandidate {
+  std::string name;
+  std::string triple;
+  int step_size;
+  // Size of the words whose bytes are reversed before decoding, 0 to decode
+  // the blob as is. Catches blobs dumped in the opposite byte order.
+  unsigned swap;
+};
+
+struct ArchGuess {
+  ArchCandidate candidate;
+  // validity * concentration * branch_consistency.
+  double score;
+  // Share of the linear sweep that decodes, or the sampled code ratio, both
+  // leaving out padding runs.
+  double validity;
+  // Confidence interval of a sampled validity, validity itself otherwise.
+  double validity_low;
+  double validity_high;
+  // Share of the decoded instructions using the TopOpcodes most frequent
+  // opcodes; real code is dominated by a few moves, loads and branches.
+  double concentration;
+  // Share of direct branches and calls that land on a decodable offset
+  // inside the blob, 0.5 if there are none.
+  double branch_consistency;
+
+  static constexpr unsigned TopOpcodes = 16;
+};
+
+/// arch_candidates - Every mode of every gapstone backend: X86 in 16-, 32-
+///   and 64-bit mode, AArch64, LoongArch, Lanai and M68k, the fixed-width
+///   ones also with swapped byte order.
+const std::vector<ArchCandidate> &arch_candidates();
+
+/// identify_architecture - Decodes blob under every candidate whose LLVM
+///   target is available, all candidates concurrently on the same queue, and
+///   ranks them by decreasing score. The LLVM targets must be initialized.
+///
+/// @param sample_rate  - Share of the offsets to decode, see
+///                       estimate_from_sample; 0 decodes the whole blob.
+std::vector<ArchGuess>
+identify_architecture(sycl::queue &q, const std::vector<uint8_t> &blob,
+                      uint64_t base_addr = 0, double sample_rate = 0.0,
+                      SampleMode mode = SampleMode::Stratified);
+
+} // namespace gapstone
+
+#endif // GAPSTONE_IDENTIFY_H
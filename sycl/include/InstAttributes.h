@@ -0,0 +1,131 @@
+#ifndef GAPSTONE_INST_ATTRIBUTES_H
+#define GAPSTONE_INST_ATTRIBUTES_H
+#include <cstdint>
+#include <llvm/MC/MCInstrDesc.h>
+
+namespace gapstone {
+
+// Packed semantic attributes of a decoded instruction. They are computed from
+// the target's MCInstrDesc inside the decode kernel, so that downstream
+// filters never need to rebuild an llvm::MCInst.
+namespace InstAttr {
+enum : uint16_t {
+  None = 0,
+  Branch = 1 << 0,
+  ConditionalBranch = 1 << 1,
+  Call = 1 << 2,
+  Return = 1 << 3,
+  Indirect = 1 << 4,
+  Load = 1 << 5,
+  Store = 1 << 6,
+  Terminator = 1 << 7,
+  Barrier = 1 << 8,
+  Trap = 1 << 9,
+  Compare = 1 << 10,
+  MoveImmediate = 1 << 11,
+};
+} // namespace InstAttr
+
+// Kind of the absolute address resolved for a PC-relative operand.
+namespace TargetKind {
+enum : uint8_t {
+  None = 0,
+  Branch = 1,
+  Call = 2,
+  // PC-relative memory reference, e.g. X86 RIP-relative operands, AArch64 adr
+  // and literal loads.
+  Memory = 3,
+  // Page base of an AArch64 adrp or LoongArch pcalau12i.
+  Page = 4,
+  // Immediate of a move-immediate instruction, possibly an address.
+  Immediate = 5,
+};
+} // namespace TargetKind
+
+/// hasDirectTarget - Whether a call or branch encodes its destination in the
+///   instruction, either as a PC-relative operand or as a trailing immediate.
+static inline bool hasDirectTarget(const llvm::MCInstrDesc &Desc) {
+  if (Desc.isIndirectBranch() || Desc.getNumOperands() == 0)
+    return false;
+  for (const auto &OpInfo : Desc.operands())
+    if (OpInfo.OperandType == llvm::MCOI::OPERAND_PCREL)
+      return true;
+  return Desc.operands().begin()[Desc.getNumOperands() - 1].RegClass == -1;
+}
+
+/// getInstAttributes - Packs the control-flow and memory properties of an
+///   instruction descriptor into an InstAttr bitfield. Usable both on the
+///   host and inside a kernel.
+///
+/// @param Desc         - The descriptor of the decoded opcode.
+/// @return             - The InstAttr bits of the opcode.
+static inline uint16_t getInstAttributes(const llvm::MCInstrDesc &Desc) {
+  uint16_t Attrs = InstAttr::None;
+  if (Desc.isBranch())
+    Attrs |= InstAttr::Branch;
+  if (Desc.isConditionalBranch())
+    Attrs |= InstAttr::ConditionalBranch;
+  if (Desc.isCall())
+    Attrs |= InstAttr::Call;
+  if (Desc.isReturn())
+    Attrs |= InstAttr::Return;
+  if (Desc.mayLoad())
+    Attrs |= InstAttr::Load;
+  if (Desc.mayStore())
+    Attrs |= InstAttr::Store;
+  if (Desc.isTerminator())
+    Attrs |= InstAttr::Terminator;
+  if (Desc.isBarrier())
+    Attrs |= InstAttr::Barrier;
+  if (Desc.isTrap())
+    Attrs |= InstAttr::Trap;
+  if (Desc.isCompare())
+    Attrs |= InstAttr::Compare;
+  if (Desc.isMoveImmediate())
+    Attrs |= InstAttr::MoveImmediate;
+
+  // Calls and branches without an encoded destination take it from a
+  // register or memory.
+  if ((Desc.isCall() || Desc.isBranch()) && !Desc.isReturn() &&
+      !hasDirectTarget(Desc))
+    Attrs |= InstAttr::Indirect;
+  return Attrs;
+}
+
+/// getImmediateOperand - Finds the first immediate operand of a decoded
+///   instruction.
+///
+/// @return             - The operand index, or -1 if there is none.
+template <typename T> static inline int getImmediateOperand(const T &MI) {
+  for (unsigned I = 0; I < MI.getNumOperands(); ++I)
+    if (MI.getOperand(I).isImm())
+      return I;
+  return -1;
+}
+
+/// getTargetOperand - Finds the operand of a decoded instruction holding its
+///   PC-relative displacement.
+///
+/// @param Desc         - The descriptor of the decoded opcode.
+/// @param MI           - The decoded instruction.
+/// @return             - The operand index, or -1 if there is none.
+template <typename T>
+static inline int getTargetOperand(const llvm::MCInstrDesc &Desc,
+                                   const T &MI) {
+  unsigned NumOperands = Desc.getNumOperands() < MI.getNumOperands()
+                             ? Desc.getNumOperands()
+                             : MI.getNumOperands();
+  for (unsigned I = 0; I < NumOperands; ++I) {
+    const auto &OpInfo = Desc.operands().begin()[I];
+    if (OpInfo.OperandType == llvm::MCOI::OPERAND_PCREL &&
+        MI.getOperand(I).isImm())
+      return I;
+  }
+  // Untagged immediates are not guessed at: far branches carry a segment and
+  // condition codes may trail the destination.
+  return -1;
+}
+
+} // namespace gapstone
+
+#endif // GAPSTONE_INST_ATTRIBUTES_H
@@ -27,6 +27,20 @@ using namespace llvm;
 using MCInstGPU_Lanai = MCInstGPU<6>;
 #define MCInst MCInstGPU_Lanai
 
+namespace gapstone {
+namespace LanaiTable {
+#define GET_INSTRINFO_MC_DESC
+#include "LanaiGenInstrInfo.inc"
+} // namespace LanaiTable
+} // namespace gapstone
+static const MCInstrDesc &getMCID(unsigned Opcode) {
+  constexpr unsigned NumOpcode =
+      sizeof(gapstone::LanaiTable::llvm::LanaiDescs.Insts) /
+      sizeof(llvm::MCInstrDesc);
+  return *(gapstone::LanaiTable::llvm::LanaiDescs.Insts + NumOpcode - 1 -
+           Opcode);
+}
+
 typedef MCDisassembler::DecodeStatus DecodeStatus;
 
 // Forward declare because the autogenerated code will reference this.
@@ -29,6 +29,20 @@ using namespace llvm;
 using MCInstGPU_LoongArch = MCInstGPU<6>;
 #define MCInst MCInstGPU_LoongArch
 
+namespace gapstone {
+namespace LoongArchTable {
+#define GET_INSTRINFO_MC_DESC
+#include "LoongArchGenInstrInfo.inc"
+} // namespace LoongArchTable
+} // namespace gapstone
+static const MCInstrDesc &getMCID(unsigned Opcode) {
+  constexpr unsigned NumOpcode =
+      sizeof(gapstone::LoongArchTable::llvm::LoongArchDescs.Insts) /
+      sizeof(llvm::MCInstrDesc);
+  return *(gapstone::LoongArchTable::llvm::LoongArchDescs.Insts + NumOpcode -
+           1 - Opcode);
+}
+
 #define DEBUG_TYPE "loongarch-disassembler"
 
 typedef MCDisassembler::DecodeStatus DecodeStatus;
@@ -33,6 +33,19 @@ using namespace llvm;
 using MCInstGPU_M68k = MCInstGPU<6>;
 #define MCInst MCInstGPU_M68k
 
+namespace gapstone {
+namespace M68kTable {
+#define GET_INSTRINFO_MC_DESC
+#include "M68kGenInstrInfo.inc"
+} // namespace M68kTable
+} // namespace gapstone
+static const MCInstrDesc &getMCID(unsigned Opcode) {
+  constexpr unsigned NumOpcode =
+      sizeof(gapstone::M68kTable::llvm::M68kDescs.Insts) /
+      sizeof(llvm::MCInstrDesc);
+  return *(gapstone::M68kTable::llvm::M68kDescs.Insts + NumOpcode - 1 - Opcode);
+}
+
 #define DEBUG_TYPE "m68k-disassembler"
 
 typedef MCDisassembler::DecodeStatus DecodeStatus;
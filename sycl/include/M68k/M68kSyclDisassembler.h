@@ -10,6 +10,19 @@ public:
   virtual std::unique_ptr<InstInfoContainer> batch_disassemble(uint64_t base_addr,
                                              std::vector<uint8_t> &content,
                                              int step_size = 4) override;
+  virtual std::unique_ptr<InstInfoContainer>
+  batch_disassemble_ranges(std::vector<uint8_t> &content,
+                           const std::vector<DecodeRange> &ranges,
+                           int step_size,
+                           const std::vector<uint64_t> *offsets =
+                               nullptr) override;
+  virtual std::unique_ptr<InstInfoContainer>
+  batch_disassemble_selected(uint64_t base_addr, std::vector<uint8_t> &content,
+                             int step_size,
+                             const std::vector<uint64_t> &offsets) override;
+  virtual std::unique_ptr<InstInfoContainer>
+  batch_disassemble_offsets(uint64_t base_addr, std::vector<uint8_t> &content,
+                            const std::vector<uint64_t> &offsets) override;
 };
 } // namespace gapstone
 
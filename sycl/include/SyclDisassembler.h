@@ -1,24 +1,143 @@
 #ifndef GAPSTONE_SYCL_DISASSEMBLER_H
 #define GAPSTONE_SYCL_DISASSEMBLER_H
 
+#include "InstAttributes.h"
+#include <algorithm>
 #include <llvm/MC/MCDisassembler/MCDisassembler.h>
 #include <llvm/MC/MCInst.h>
+#include <memory>
+#include <stdexcept>
 #include <sycl/sycl.hpp>
+#include <vector>
 
 namespace gapstone {
 
+struct FunctionCandidate;
+struct JumpTable;
+struct ResolvedAddress;
+
+// A range of a buffer holding code, and the address its first byte is
+// loaded at.
+struct DecodeRange {
+  uint64_t address;
+  // Offset of the range in the buffer.
+  uint64_t offset;
+  uint64_t size;
+};
+
+// Returned by range_offset for an address no range holds.
+constexpr uint64_t NoOffset = ~uint64_t(0);
+
+/// range_at - Index of the last of the ranges, sorted by offset, starting at
+///   or before offset, 0 if none does.
+static inline uint64_t range_at(const DecodeRange *ranges,
+                                uint64_t num_ranges, uint64_t offset) {
+  uint64_t low = 0, high = num_ranges;
+  while (high - low > 1) {
+    uint64_t mid = (low + high) / 2;
+    if (ranges[mid].offset <= offset)
+      low = mid;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+/// range_address - Address of the byte at offset of a buffer packing the
+///   ranges, base_addr + offset when there are none.
+static inline uint64_t range_address(const DecodeRange *ranges,
+                                     uint64_t num_ranges, uint64_t base_addr,
+                                     uint64_t offset) {
+  if (num_ranges == 0)
+    return base_addr + offset;
+  const DecodeRange &range = ranges[range_at(ranges, num_ranges, offset)];
+  return range.address + (offset - range.offset);
+}
+
+/// range_offset - Offset of the byte loaded at address in a buffer packing
+///   the ranges, sorted by address as well, or NoOffset. Where ranges
+///   overlap, the last one starting at or below address is taken.
+static inline uint64_t range_offset(const DecodeRange *ranges,
+                                    uint64_t num_ranges, uint64_t base_addr,
+                                    uint64_t address) {
+  if (num_ranges == 0)
+    return address < base_addr ? NoOffset : address - base_addr;
+  if (address < ranges[0].address)
+    return NoOffset;
+  uint64_t low = 0, high = num_ranges;
+  while (high - low > 1) {
+    uint64_t mid = (low + high) / 2;
+    if (ranges[mid].address <= address)
+      low = mid;
+    else
+      high = mid;
+  }
+  const DecodeRange &range = ranges[low];
+  if (address - range.address >= range.size)
+    return NoOffset;
+  return range.offset + (address - range.address);
+}
+
 struct InstInfoContainer {
   uint64_t size;
+  // Entry i describes the offset i * step_size, at address base_addr + offset.
+  uint64_t base_addr = 0;
+  int step_size = 1;
   std::vector<llvm::MCDisassembler::DecodeStatus> status;
-  InstInfoContainer(uint64_t n): status(std::vector<llvm::MCDisassembler::DecodeStatus>(n)) {}
+  // Decoded length in bytes, 0 if nothing could be decoded.
+  std::vector<uint8_t> sizes;
+  // InstAttr bits of every decoded instruction, see InstAttributes.h.
+  std::vector<uint16_t> attributes;
+  // Absolute address referenced by a PC-relative operand, and its TargetKind.
+  std::vector<uint64_t> targets;
+  std::vector<uint8_t> target_kinds;
+  // Target opcode of every decoded instruction, 0 if nothing was decoded.
+  std::vector<uint16_t> opcodes;
+  // Set by batch_disassemble_ranges: the ranges of the packed buffer, whose
+  // offset i * step_size entry i describes, and base_addr is unused.
+  std::vector<DecodeRange> ranges;
+  InstInfoContainer(uint64_t n)
+      : size(n), status(std::vector<llvm::MCDisassembler::DecodeStatus>(n)),
+        sizes(std::vector<uint8_t>(n)), attributes(std::vector<uint16_t>(n)),
+        targets(std::vector<uint64_t>(n)),
+        target_kinds(std::vector<uint8_t>(n)),
+        opcodes(std::vector<uint16_t>(n)) {}
+  uint64_t address(uint64_t i) const {
+    return range_address(ranges.data(), ranges.size(), base_addr,
+                         i * step_size);
+  }
   virtual llvm::MCInst getMCInst(uint64_t i) = 0;
+  // The count entries from first, as a container of their own.
+  virtual std::unique_ptr<InstInfoContainer> slice(uint64_t first,
+                                                   uint64_t count) = 0;
   virtual ~InstInfoContainer() = default;
+
+protected:
+  void copy_slice(InstInfoContainer &res, uint64_t first,
+                  uint64_t count) const {
+    res.base_addr = address(first);
+    res.step_size = step_size;
+    std::copy_n(status.begin() + first, count, res.status.begin());
+    std::copy_n(sizes.begin() + first, count, res.sizes.begin());
+    std::copy_n(attributes.begin() + first, count, res.attributes.begin());
+    std::copy_n(targets.begin() + first, count, res.targets.begin());
+    std::copy_n(target_kinds.begin() + first, count,
+                res.target_kinds.begin());
+    std::copy_n(opcodes.begin() + first, count, res.opcodes.begin());
+  }
 };
 
 struct InstInfoContainerCPU : InstInfoContainer {
   std::vector<llvm::MCInst> insts;
   InstInfoContainerCPU(uint64_t n): InstInfoContainer(n), insts(std::vector<llvm::MCInst>(n)) {} 
   llvm::MCInst getMCInst(uint64_t i) override { return insts[i]; };
+  std::unique_ptr<InstInfoContainer> slice(uint64_t first,
+                                           uint64_t count) override {
+    auto res = std::make_unique<InstInfoContainerCPU>(count);
+    copy_slice(*res, first, count);
+    std::copy_n(insts.begin() + first, count, res->insts.begin());
+    return res;
+  }
 };
 
 template <typename T> struct InstInfoContainerGPU : InstInfoContainer {
@@ -34,6 +153,19 @@ template <typename T> struct InstInfoContainerGPU : InstInfoContainer {
     }
     return res;
   };
+  std::unique_ptr<InstInfoContainer> slice(uint64_t first,
+                                           uint64_t count) override {
+    auto res = std::make_unique<InstInfoContainerGPU<T>>(count);
+    copy_slice(*res, first, count);
+    std::copy_n(insts.begin() + first, count, res->insts.begin());
+    return res;
+  }
+};
+
+// Span bytes of code starting at an absolute address.
+struct AddressRange {
+  uint64_t address;
+  uint64_t span;
 };
 
 class SyclDisassembler {
@@ -49,6 +181,134 @@ public:
   virtual std::unique_ptr<InstInfoContainer> batch_disassemble(uint64_t base_addr,
                                       std::vector<uint8_t> &content,
                                       int step_size = 1) = 0;
+
+  /// batch_disassemble_ranges - batch_disassemble of ranges packed one
+  ///   after the other in content, e.g. all the executable sections of an
+  ///   image, in a single launch. Entry i describes the offset
+  ///   i * step_size and its address follows the range holding it, see
+  ///   InstInfoContainer::ranges. Instructions do not extend past the end of
+  ///   their range and the offsets outside every range read as failed.
+  ///
+  /// @param ranges       - Sorted by offset, with step-aligned offsets, not
+  ///                       overlapping in content. Resolving addresses to
+  ///                       entries needs them sorted by address as well.
+  /// @param offsets      - When given, only these step-aligned offsets are
+  ///                       decoded, e.g. those left by scan_padding.
+  virtual std::unique_ptr<InstInfoContainer>
+  batch_disassemble_ranges(std::vector<uint8_t> &content,
+                           const std::vector<DecodeRange> &ranges,
+                           int step_size,
+                           const std::vector<uint64_t> *offsets = nullptr) {
+    throw std::invalid_argument("Not implemented yet");
+  }
+
+  /// batch_disassemble_selected - batch_disassemble of only the given
+  ///   step-aligned offsets, e.g. those left by scan_padding. The other
+  ///   entries are not decoded and read as failed.
+  virtual std::unique_ptr<InstInfoContainer>
+  batch_disassemble_selected(uint64_t base_addr, std::vector<uint8_t> &content,
+                             int step_size,
+                             const std::vector<uint64_t> &offsets) {
+    throw std::invalid_argument("Not implemented yet");
+  }
+
+  /// disassemble_ranges - Decodes scattered ranges of a buffer loaded at
+  ///   base_addr in one launch: the ranges are clipped to the buffer and
+  ///   packed for batch_disassemble_ranges, so only their bytes are
+  ///   uploaded.
+  ///
+  /// @return             - Result k describes ranges[k], empty when the
+  ///                       range lies outside the buffer.
+  std::vector<std::unique_ptr<InstInfoContainer>>
+  disassemble_ranges(uint64_t base_addr, std::vector<uint8_t> &content,
+                     const std::vector<AddressRange> &ranges,
+                     int step_size = 1) {
+    std::vector<DecodeRange> table;
+    std::vector<uint8_t> packed;
+    table.reserve(ranges.size());
+    for (const AddressRange &range : ranges) {
+      uint64_t offset = range.address - base_addr;
+      uint64_t size = 0;
+      if (range.address >= base_addr && offset < content.size())
+        size = std::min<uint64_t>(range.span, content.size() - offset);
+      table.push_back({range.address, packed.size(), size});
+      if (size)
+        packed.insert(packed.end(), content.begin() + offset,
+                      content.begin() + offset + size);
+      packed.resize((packed.size() + step_size - 1) / step_size * step_size);
+    }
+    std::vector<std::unique_ptr<InstInfoContainer>> res;
+    auto insts = batch_disassemble_ranges(packed, table, step_size);
+    for (const DecodeRange &range : table)
+      res.push_back(insts->slice(range.offset / step_size,
+                                 range.size / step_size));
+    return res;
+  }
+
+  /// disassemble_addresses - Decodes one instruction at each of the sorted
+  ///   absolute addresses in one launch, see batch_disassemble_offsets.
+  ///
+  /// @return             - Entry k describes addresses[k] and fails to
+  ///                       decode when it lies outside the buffer.
+  std::unique_ptr<InstInfoContainer>
+  disassemble_addresses(uint64_t base_addr, std::vector<uint8_t> &content,
+                        const std::vector<uint64_t> &addresses) {
+    if (!std::is_sorted(addresses.begin(), addresses.end()))
+      throw std::invalid_argument("Addresses must be sorted");
+    std::vector<uint64_t> offsets;
+    offsets.reserve(addresses.size());
+    for (uint64_t address : addresses)
+      offsets.push_back(address < base_addr ? content.size()
+                                            : address - base_addr);
+    return batch_disassemble_offsets(base_addr, content, offsets);
+  }
+
+  /// batch_disassemble_offsets - Decodes only the given offsets of content.
+  ///   Entry k of the result describes offsets[k], so the result has no step
+  ///   geometry and index_of/next do not apply to it.
+  ///
+  /// @param offsets      - Byte offsets into content, in any order.
+  virtual std::unique_ptr<InstInfoContainer>
+  batch_disassemble_offsets(uint64_t base_addr, std::vector<uint8_t> &content,
+                            const std::vector<uint64_t> &offsets) {
+    throw std::invalid_argument("Not implemented yet");
+  }
+
+  /// function_starts - Scores every decoded offset as a possible function
+  ///   entry and returns the candidates.
+  ///
+  /// @param insts        - Superset decode of content.
+  /// @param content      - The bytes insts was decoded from.
+  /// @return             - Ranked by decreasing score where the evidence is
+  ///                       heuristic (X86), otherwise one entry per function
+  ///                       sorted by address (AArch64).
+  virtual std::vector<FunctionCandidate>
+  function_starts(InstInfoContainer &insts, std::vector<uint8_t> &content);
+
+  /// resolve_address_pairs - Matches every page-forming instruction with the
+  ///   instructions completing its address within the next window
+  ///   instructions.
+  ///
+  /// @param insts        - Superset decode of content.
+  /// @param content      - The bytes insts was decoded from.
+  /// @return             - The resolved addresses, ordered by page-forming
+  ///                       instruction, then by consumer.
+  virtual std::vector<ResolvedAddress>
+  resolve_address_pairs(InstInfoContainer &insts,
+                        std::vector<uint8_t> &content, unsigned window = 8);
+
+  /// find_jump_tables - Matches the indirect jumps that load their target
+  ///   from a table and describes each table. The entries are not checked,
+  ///   see validate_jump_tables.
+  ///
+  /// @param insts        - Superset decode of content.
+  /// @param content      - The bytes insts was decoded from.
+  /// @param mask         - Host flags selecting the instructions to match,
+  ///                       may be empty.
+  /// @return             - One candidate table per jump, num_entries is 0.
+  virtual std::vector<JumpTable>
+  find_jump_tables(InstInfoContainer &insts, std::vector<uint8_t> &content,
+                   const std::vector<uint8_t> &mask);
 };
 } // namespace gapstone
 
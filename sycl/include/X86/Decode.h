@@ -108,6 +108,12 @@ static const char *getInstrNameById(uint16_t instructionID) {
   return &gapstone::X86Table::llvm::X86InstrNameData
       [gapstone::X86Table::llvm::X86InstrNameIndices[instructionID]];
 }
+static const MCInstrDesc &getMCID(unsigned Opcode) {
+  constexpr unsigned NumOpcode =
+      sizeof(gapstone::X86Table::llvm::X86Descs.Insts) /
+      sizeof(llvm::MCInstrDesc);
+  return *(gapstone::X86Table::llvm::X86Descs.Insts + NumOpcode - 1 - Opcode);
+}
 
 // Specifies whether a ModR/M byte is needed and (if so) which
 // instruction each possible value of the ModR/M byte corresponds to.  Once
@@ -0,0 +1,142 @@
+#include "Analysis/BaseAddress.h"
+#include "Analysis/LinearSweep.h"
+#include "Analysis/Superset.h"
+#include <algorithm>
+
+namespace gapstone {
+namespace {
+static bool is_printable(uint8_t c) {
+  return (c >= 0x20 && c < 0x7f) || c == '\t' || c == '\n' || c == '\r';
+}
+
+static uint64_t read_pointer(const uint8_t *p, unsigned size, bool big_endian) {
+  uint64_t value = 0;
+  for (unsigned b = 0; b < size; ++b)
+    value |= uint64_t(p[big_endian ? size - 1 - b : b]) << (8 * b);
+  return value;
+}
+} // namespace
+
+std::vector<BaseCandidate> infer_base_address(sycl::queue &q,
+                                              const SupersetView &view,
+                                              const uint8_t *image,
+                                              uint64_t image_size,
+                                              const BaseSearch &search,
+                                              unsigned count) {
+  if (image_size == 0 || search.high <= search.low || search.alignment == 0)
+    return {};
+  uint64_t low = search.low, alignment = search.alignment;
+  uint64_t num_candidates = (search.high - low + alignment - 1) / alignment;
+  unsigned pointer_size = search.pointer_size;
+  bool big_endian = search.big_endian;
+  unsigned min_string = search.min_string;
+  uint64_t max_pointer =
+      pointer_size >= 8 ? ~uint64_t(0) : (uint64_t(1) << (8 * pointer_size)) - 1;
+
+  uint8_t *anchors = sycl::malloc_device<uint8_t>(image_size, q);
+  uint32_t *hits = sycl::malloc_device<uint32_t>(num_candidates, q);
+  uint8_t *swept = sycl::malloc_device<uint8_t>(view.tasks, q);
+  q.memset(anchors, 0, image_size);
+  q.memset(hits, 0, num_candidates * sizeof(uint32_t));
+  q.wait();
+  // Only the instruction stream votes; the superset decodes about as many
+  // spurious targets inside data and instruction tails.
+  linear_sweep(q, view, swept);
+  q.parallel_for(image_size, [=](sycl::id<1> o) {
+     if (o != 0 && image[o - 1] != 0)
+       return;
+     uint64_t end = o + min_string;
+     if (end > image_size)
+       return;
+     for (uint64_t k = o; k < end; ++k)
+       if (!is_printable(image[k]))
+         return;
+     anchors[o] = 1;
+   }).wait();
+  q.parallel_for(view.tasks, [=](sycl::id<1> i) {
+     if (!swept[i])
+       return;
+     uint8_t kind = view.target_kinds[i];
+     if (kind != TargetKind::Branch && kind != TargetKind::Call &&
+         kind != TargetKind::Memory)
+       return;
+     // The image was decoded at base 0, so targets are offsets.
+     uint64_t target = view.targets[i];
+     if (target >= image_size)
+       return;
+     if (kind == TargetKind::Memory) {
+       anchors[target] = 1;
+       return;
+     }
+     uint64_t j = view.index_of(target);
+     if (j != view.tasks && view.valid(j))
+       anchors[target] = 1;
+   }).wait();
+
+  uint64_t num_words = image_size / pointer_size;
+  q.parallel_for(num_words + view.tasks, [=](sycl::id<1> p) {
+     uint64_t value;
+     if (p < num_words) {
+       value = read_pointer(image + p * pointer_size, pointer_size, big_endian);
+     } else {
+       uint64_t i = p - num_words;
+       if (!swept[i] || view.target_kinds[i] != TargetKind::Immediate)
+         return;
+       value = view.targets[i];
+     }
+     // Zero and all-ones words are padding far more often than pointers.
+     if (value == 0 || value == max_pointer || value < low)
+       return;
+     // Candidates placing value inside the image.
+     uint64_t first = value - low < image_size
+                          ? 0
+                          : (value - low - image_size + alignment) / alignment;
+     uint64_t last = (value - low) / alignment;
+     if (last >= num_candidates)
+       last = num_candidates - 1;
+     for (uint64_t k = first; k <= last; ++k) {
+       if (!anchors[value - (low + k * alignment)])
+         continue;
+       sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed,
+                        sycl::memory_scope::device>
+           hit(hits[k]);
+       hit.fetch_add(1);
+     }
+   }).wait();
+
+  std::vector<uint32_t> host_hits(num_candidates);
+  q.memcpy(host_hits.data(), hits, num_candidates * sizeof(uint32_t)).wait();
+  sycl::free(swept, q);
+  sycl::free(hits, q);
+  sycl::free(anchors, q);
+
+  std::vector<BaseCandidate> res;
+  for (uint64_t k = 0; k < num_candidates; ++k)
+    if (host_hits[k])
+      res.push_back({low + k * alignment, host_hits[k]});
+  auto by_hits = [](const BaseCandidate &a, const BaseCandidate &b) {
+    return a.hits > b.hits || (a.hits == b.hits && a.base < b.base);
+  };
+  if (res.size() > count) {
+    std::partial_sort(res.begin(), res.begin() + count, res.end(), by_hits);
+    res.resize(count);
+  } else {
+    std::sort(res.begin(), res.end(), by_hits);
+  }
+  return res;
+}
+
+std::vector<BaseCandidate> infer_base_address(sycl::queue &q,
+                                              const InstInfoContainer &insts,
+                                              const std::vector<uint8_t> &image,
+                                              const BaseSearch &search,
+                                              unsigned count) {
+  DeviceSuperset superset(q, insts);
+  uint8_t *device_image = sycl::malloc_device<uint8_t>(image.size(), q);
+  q.memcpy(device_image, image.data(), image.size()).wait();
+  auto res = infer_base_address(q, superset.view(), device_image, image.size(),
+                                search, count);
+  sycl::free(device_image, q);
+  return res;
+}
+} // namespace gapstone
@@ -0,0 +1,126 @@
+#include "Analysis/CallGraph.h"
+#include "Analysis/Primitives.h"
+#include "Analysis/Superset.h"
+#include <boost/graph/graphml.hpp>
+#include <boost/graph/graphviz.hpp>
+#include <boost/property_map/dynamic_property_map.hpp>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+namespace gapstone {
+// Superset entries of the call instructions inside a block.
+static std::vector<uint64_t> find_call_sites(sycl::queue &q,
+                                             const InstInfoContainer &insts,
+                                             const ProgramPartition &partition) {
+  DeviceSuperset superset(q, insts);
+  SupersetView view = superset.view();
+  uint64_t tasks = view.tasks;
+  uint64_t *block_of = sycl::malloc_device<uint64_t>(tasks, q);
+  uint8_t *flags = sycl::malloc_device<uint8_t>(tasks, q);
+  q.memcpy(block_of, partition.block_of.data(), tasks * sizeof(uint64_t))
+      .wait();
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     flags[i] = view.valid(i) && block_of[i] != ProgramPartition::NoBlock &&
+                (view.attributes[i] & InstAttr::Call);
+   }).wait();
+  uint64_t count;
+  uint64_t *sites = compact_indices(q, flags, tasks, count);
+  std::vector<uint64_t> res(count);
+  q.memcpy(res.data(), sites, count * sizeof(uint64_t)).wait();
+  sycl::free(sites, q);
+  sycl::free(flags, q);
+  sycl::free(block_of, q);
+  return res;
+}
+
+CallGraph build_call_graph(sycl::queue &q, const InstInfoContainer &insts,
+                           const ProgramPartition &partition,
+                           const std::vector<ImportSlot> &imports) {
+  SupersetView view = host_view(insts);
+  std::vector<CallGraphVertex> vertices;
+  std::unordered_map<uint64_t, uint64_t> function_at;
+  for (auto &function : partition.functions) {
+    std::stringstream name;
+    name << "sub_" << std::hex << function.entry;
+    function_at[function.entry] = vertices.size();
+    vertices.push_back({name.str(), function.entry});
+  }
+  std::unordered_map<std::string, uint64_t> import_vertex;
+  std::unordered_map<uint64_t, uint64_t> import_at;
+  for (auto &slot : imports) {
+    auto it = import_vertex.find(slot.name);
+    if (it == import_vertex.end()) {
+      it = import_vertex.emplace(slot.name, vertices.size()).first;
+      vertices.push_back({slot.name, 0});
+    }
+    import_at[slot.address] = it->second;
+  }
+
+  const uint64_t None = ~uint64_t(0);
+  // Import loaded or jumped through by entry i.
+  auto slot_import = [&](uint64_t i) {
+    if (view.target_kinds[i] != TargetKind::Memory)
+      return None;
+    auto it = import_at.find(view.targets[i]);
+    return it == import_at.end() ? None : it->second;
+  };
+  // Import a PLT stub at Address jumps to.
+  auto stub_import = [&](uint64_t Address) {
+    uint64_t i = view.index_of(Address);
+    if (i == view.tasks || !view.valid(i) ||
+        !(view.attributes[i] & InstAttr::Branch))
+      return None;
+    return slot_import(i);
+  };
+
+  std::vector<std::pair<uint64_t, uint64_t>> edges;
+  std::vector<CallGraphEdge> edge_properties;
+  for (auto i : find_call_sites(q, insts, partition)) {
+    auto &block = partition.blocks[partition.block_of[i]];
+    uint64_t callee = None;
+    if (view.target_kinds[i] == TargetKind::Call) {
+      callee = stub_import(view.targets[i]);
+      if (callee == None) {
+        auto it = function_at.find(view.targets[i]);
+        if (it != function_at.end())
+          callee = it->second;
+      }
+    } else if (view.target_kinds[i] == TargetKind::Memory) {
+      callee = slot_import(i);
+    } else if (i != block.first) {
+      uint64_t prev = block.first;
+      while (view.next(prev) != i)
+        prev = view.next(prev);
+      if (view.attributes[prev] & InstAttr::Load)
+        callee = slot_import(prev);
+    }
+    if (callee == None)
+      continue;
+    edges.emplace_back(block.function, callee);
+    edge_properties.push_back({view.address(i)});
+  }
+
+  CallGraph graph(boost::edges_are_unsorted_multi_pass, edges.begin(),
+                  edges.end(), edge_properties.begin(), vertices.size());
+  for (uint64_t v = 0; v < vertices.size(); ++v)
+    graph[v] = vertices[v];
+  return graph;
+}
+
+static boost::dynamic_properties call_graph_properties(CallGraph &graph) {
+  boost::dynamic_properties dp(boost::ignore_other_properties);
+  dp.property("name", boost::get(&CallGraphVertex::name, graph));
+  dp.property("address", boost::get(&CallGraphVertex::address, graph));
+  dp.property("call_site", boost::get(&CallGraphEdge::call_site, graph));
+  return dp;
+}
+
+void write_call_graph_graphml(std::ostream &os, CallGraph &graph) {
+  boost::write_graphml(os, graph, call_graph_properties(graph), true);
+}
+
+void write_call_graph_dot(std::ostream &os, CallGraph &graph) {
+  boost::write_graphviz_dp(os, graph, call_graph_properties(graph), "name");
+}
+} // namespace gapstone
@@ -0,0 +1,150 @@
+#include "Analysis/CodeProbability.h"
+#include "Analysis/Prune.h"
+#include "Analysis/Superset.h"
+#include <utility>
+
+namespace gapstone {
+namespace {
+// Longest instruction of any supported target, in bytes.
+constexpr uint64_t MaxInstSize = 15;
+// Probabilities are exchanged through integer atomics in this fixed point.
+constexpr float FixedOne = float(1 << 24);
+// Log-odds weights of the prior evidence.
+constexpr float DirectTransferWeight = 1.0f;
+constexpr float TrapWeight = -1.5f;
+constexpr float DataReferenceWeight = -2.0f;
+// Fraction of an overlapping instruction's probability taken from an entry.
+constexpr float OverlapPenalty = 0.5f;
+// Weight of the previous round in the damped update.
+constexpr float Damping = 0.5f;
+
+static uint32_t to_fixed(float p) { return uint32_t(p * FixedOne); }
+static float from_fixed(uint32_t p) { return float(p) / FixedOne; }
+
+static void raise_to(uint32_t *slots, uint64_t i, uint32_t value) {
+  sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed,
+                   sycl::memory_scope::device>
+      slot(slots[i]);
+  slot.fetch_max(value);
+}
+
+// Highest probability among the valid entries overlapping entry i.
+static float overlap(const SupersetView &view, const float *p, uint64_t i) {
+  float res = 0.0f;
+  uint64_t offset = i * view.step_size;
+  for (uint64_t d = 1; d * view.step_size < MaxInstSize && d <= i; ++d) {
+    uint64_t j = i - d;
+    if (view.valid(j) && j * view.step_size + view.sizes[j] > offset)
+      res = sycl::fmax(res, p[j]);
+  }
+  for (uint64_t k = i + 1;
+       k < view.tasks && k * view.step_size < offset + view.sizes[i]; ++k)
+    if (view.valid(k))
+      res = sycl::fmax(res, p[k]);
+  return res;
+}
+
+// Upper bound on the probability of entry i left by its competitors.
+static float ceiling(const SupersetView &view, const float *p, uint64_t i) {
+  return 1.0f - OverlapPenalty * overlap(view, p, i);
+}
+} // namespace
+
+unsigned code_probabilities(sycl::queue &q, const SupersetView &view,
+                            float *probabilities, unsigned max_rounds,
+                            float epsilon) {
+  uint64_t tasks = view.tasks;
+  if (tasks == 0)
+    return 0;
+  float *prior = sycl::malloc_device<float>(tasks, q);
+  float *next = sycl::malloc_device<float>(tasks, q);
+  uint8_t *keep = sycl::malloc_device<uint8_t>(tasks, q);
+  uint32_t *data_refs = sycl::malloc_device<uint32_t>(tasks, q);
+  uint32_t *support = sycl::malloc_device<uint32_t>(tasks, q);
+  uint32_t *delta = sycl::malloc_shared<uint32_t>(1, q);
+  float *p = probabilities;
+
+  // Chains running into undecodable bytes are data for certain.
+  prune_invalid_chains(q, view, keep);
+  q.memset(data_refs, 0, tasks * sizeof(uint32_t)).wait();
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     if (!view.valid(i) || view.target_kinds[i] != TargetKind::Memory)
+       return;
+     uint64_t target = view.index_of(view.targets[i]);
+     if (target != tasks)
+       raise_to(data_refs, target, 1);
+   }).wait();
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     if (!keep[i]) {
+       prior[i] = p[i] = 0.0f;
+       return;
+     }
+     float odds = 0.0f;
+     if (view.branch_target(i) != tasks)
+       odds += DirectTransferWeight;
+     if (view.attributes[i] & InstAttr::Trap)
+       odds += TrapWeight;
+     if (data_refs[i])
+       odds += DataReferenceWeight;
+     prior[i] = p[i] = 1.0f / (1.0f + sycl::exp(-odds));
+   }).wait();
+
+  unsigned rounds = 0;
+  while (rounds < max_rounds) {
+    ++rounds;
+    q.memset(support, 0, tasks * sizeof(uint32_t)).wait();
+    q.parallel_for(tasks, [=](sycl::id<1> i) {
+       if (!keep[i])
+         return;
+       uint32_t value = to_fixed(p[i]);
+       uint64_t succ = view.ends_flow(i) ? tasks : view.next(i);
+       if (succ != tasks)
+         raise_to(support, succ, value);
+       uint64_t target = view.branch_target(i);
+       if (target != tasks)
+         raise_to(support, target, value);
+     }).wait();
+    *delta = 0;
+    q.parallel_for(tasks, [=](sycl::id<1> i) {
+       // Pruned entries stay at 0 whatever support flows into them.
+       if (!keep[i]) {
+         next[i] = 0.0f;
+         return;
+       }
+       float belief = sycl::fmax(prior[i], from_fixed(support[i])) *
+                      ceiling(view, p, i);
+       uint64_t succ = view.ends_flow(i) ? tasks : view.next(i);
+       if (succ != tasks)
+         belief = sycl::fmin(belief, ceiling(view, p, succ));
+       next[i] = Damping * p[i] + (1.0f - Damping) * belief;
+       raise_to(delta, 0, to_fixed(sycl::fabs(next[i] - p[i])));
+     }).wait();
+    std::swap(p, next);
+    if (from_fixed(*delta) <= epsilon)
+      break;
+  }
+  if (p != probabilities)
+    q.memcpy(probabilities, p, tasks * sizeof(float)).wait();
+
+  sycl::free(delta, q);
+  sycl::free(support, q);
+  sycl::free(data_refs, q);
+  sycl::free(keep, q);
+  // Whichever of p and next is not the caller's array was allocated here.
+  sycl::free(p != probabilities ? p : next, q);
+  sycl::free(prior, q);
+  return rounds;
+}
+
+std::vector<float> code_probabilities(sycl::queue &q,
+                                      const InstInfoContainer &insts,
+                                      unsigned max_rounds, float epsilon) {
+  DeviceSuperset superset(q, insts);
+  float *probabilities = sycl::malloc_device<float>(superset.tasks(), q);
+  code_probabilities(q, superset.view(), probabilities, max_rounds, epsilon);
+  std::vector<float> res(superset.tasks());
+  q.memcpy(res.data(), probabilities, res.size() * sizeof(float)).wait();
+  sycl::free(probabilities, q);
+  return res;
+}
+} // namespace gapstone
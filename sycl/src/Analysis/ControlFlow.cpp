@@ -0,0 +1,124 @@
+#include "Analysis/ControlFlow.h"
+#include "Analysis/Primitives.h"
+#include "Analysis/Superset.h"
+
+namespace gapstone {
+static bool selected(const SupersetView &view, const uint8_t *mask,
+                     uint64_t i) {
+  return i < view.tasks && view.valid(i) && (!mask || mask[i]);
+}
+
+// Out-edges of entry i, at most two, sorted by destination with duplicates
+// merged.
+static unsigned get_edges(const SupersetView &view, const uint8_t *mask,
+                          uint64_t i, uint64_t *dst, uint8_t *kind) {
+  if (!selected(view, mask, i))
+    return 0;
+  unsigned n = 0;
+  uint64_t target = view.branch_target(i);
+  if (selected(view, mask, target)) {
+    dst[n] = target;
+    if (view.target_kinds[i] == TargetKind::Call)
+      kind[n] = EdgeKind::Call;
+    else if (view.attributes[i] & InstAttr::ConditionalBranch)
+      kind[n] = EdgeKind::ConditionalBranch;
+    else
+      kind[n] = EdgeKind::Branch;
+    ++n;
+  }
+  uint64_t next = view.next(i);
+  if (!view.ends_flow(i) && selected(view, mask, next) &&
+      (n == 0 || dst[0] != next)) {
+    dst[n] = next;
+    kind[n] = EdgeKind::FallThrough;
+    if (n == 1 && dst[1] < dst[0]) {
+      uint64_t d = dst[0];
+      uint8_t k = kind[0];
+      dst[0] = dst[1], kind[0] = kind[1];
+      dst[1] = d, kind[1] = k;
+    }
+    ++n;
+  }
+  return n;
+}
+
+ControlFlowGraph build_control_flow_graph(sycl::queue &q,
+                                          const SupersetView &view,
+                                          const uint8_t *mask) {
+  ControlFlowGraph res;
+  uint64_t tasks = view.tasks;
+  res.num_vertices = tasks;
+  res.base_addr = view.base_addr;
+  res.step_size = view.step_size;
+  res.ranges.resize(view.num_ranges);
+  if (view.num_ranges)
+    q.memcpy(res.ranges.data(), view.ranges,
+             view.num_ranges * sizeof(DecodeRange));
+  res.offsets.resize(tasks + 1);
+  uint64_t *offsets = sycl::malloc_device<uint64_t>(tasks + 1, q);
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     uint64_t dst[2];
+     uint8_t kind[2];
+     offsets[i] = get_edges(view, mask, i, dst, kind);
+   }).wait();
+  // Edges are produced grouped by source, so the row offsets are a prefix
+  // sum of the per-entry counts and no global sort is needed.
+  uint64_t edges = exclusive_scan(q, offsets, offsets, tasks);
+  q.memcpy(offsets + tasks, &edges, sizeof(uint64_t)).wait();
+  uint64_t *columns = sycl::malloc_device<uint64_t>(edges, q);
+  uint8_t *kinds = sycl::malloc_device<uint8_t>(edges, q);
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     uint64_t dst[2];
+     uint8_t kind[2];
+     unsigned n = get_edges(view, mask, i, dst, kind);
+     for (unsigned k = 0; k < n; ++k) {
+       columns[offsets[i] + k] = dst[k];
+       kinds[offsets[i] + k] = kind[k];
+     }
+   }).wait();
+  res.columns.resize(edges);
+  res.kinds.resize(edges);
+  q.memcpy(res.offsets.data(), offsets, (tasks + 1) * sizeof(uint64_t));
+  q.memcpy(res.columns.data(), columns, edges * sizeof(uint64_t));
+  q.memcpy(res.kinds.data(), kinds, edges * sizeof(uint8_t));
+  q.wait();
+  sycl::free(kinds, q);
+  sycl::free(columns, q);
+  sycl::free(offsets, q);
+  return res;
+}
+
+DeviceControlFlowGraph::DeviceControlFlowGraph(sycl::queue &qq,
+                                               const ControlFlowGraph &cfg)
+    : q(qq) {
+  uint64_t *offsets = sycl::malloc_device<uint64_t>(cfg.offsets.size(), q);
+  uint64_t *columns = sycl::malloc_device<uint64_t>(cfg.num_edges(), q);
+  uint8_t *kinds = sycl::malloc_device<uint8_t>(cfg.num_edges(), q);
+  q.memcpy(offsets, cfg.offsets.data(), cfg.offsets.size() * sizeof(uint64_t));
+  q.memcpy(columns, cfg.columns.data(), cfg.num_edges() * sizeof(uint64_t));
+  q.memcpy(kinds, cfg.kinds.data(), cfg.num_edges() * sizeof(uint8_t));
+  q.wait();
+  View = {offsets, columns, kinds, cfg.num_vertices};
+}
+
+DeviceControlFlowGraph::~DeviceControlFlowGraph() {
+  sycl::free(const_cast<uint64_t *>(View.offsets), q);
+  sycl::free(const_cast<uint64_t *>(View.columns), q);
+  sycl::free(const_cast<uint8_t *>(View.kinds), q);
+}
+
+ControlFlowGraph build_control_flow_graph(sycl::queue &q,
+                                          const InstInfoContainer &insts,
+                                          const std::vector<uint8_t> &mask) {
+  DeviceSuperset superset(q, insts);
+  uint8_t *mask_device = nullptr;
+  if (!mask.empty()) {
+    mask_device = sycl::malloc_device<uint8_t>(mask.size(), q);
+    q.memcpy(mask_device, mask.data(), mask.size()).wait();
+  }
+  auto res = build_control_flow_graph(q, superset.view(), mask_device);
+  if (mask_device)
+    sycl::free(mask_device, q);
+  return res;
+}
+} // namespace gapstone
@@ -0,0 +1,262 @@
+#include "Analysis/Diff.h"
+#include "Analysis/Primitives.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+namespace gapstone {
+namespace {
+// Instructions of one function, their keys and the hash of the keys.
+struct FunctionSequence {
+  std::vector<uint64_t> entries;
+  std::vector<uint64_t> keys;
+  uint64_t hash;
+};
+
+// Whether imm encodes target in one of the PC-relative forms of the
+// supported targets: in bytes or words from the instruction, in bytes from
+// its end, in pages, or as the absolute address.
+static bool encodes_target(int64_t imm, uint64_t address, uint64_t size,
+                           uint64_t target) {
+  uint64_t value = imm;
+  return address + value == target || address + size + value == target ||
+         address + value * 4 == target ||
+         (address & ~uint64_t(0xfff)) + (value << 12) == target ||
+         value == target;
+}
+
+// Key of entry i: its opcode, registers and immediates, except for the
+// immediate holding its PC-relative destination, so that code that only
+// moved, or refers to code that moved, keeps its key.
+static uint64_t instruction_key(InstInfoContainer &insts, uint64_t i) {
+  enum : uint64_t { Reg = 1, Imm = 2, Target = 3, Other = 4 };
+  llvm::MCInst inst = insts.getMCInst(i);
+  uint8_t kind = insts.target_kinds[i];
+  bool relative = kind == TargetKind::Branch || kind == TargetKind::Call ||
+                  kind == TargetKind::Memory || kind == TargetKind::Page;
+  uint64_t address = insts.address(i);
+  uint64_t key = mix64(inst.getOpcode());
+  for (const llvm::MCOperand &operand : inst) {
+    uint64_t tag = Other, value = 0;
+    if (operand.isReg()) {
+      tag = Reg;
+      value = operand.getReg();
+    } else if (operand.isImm() && relative &&
+               encodes_target(operand.getImm(), address, insts.sizes[i],
+                              insts.targets[i])) {
+      // Only the first match is the destination.
+      tag = Target;
+      relative = false;
+    } else if (operand.isImm()) {
+      tag = Imm;
+      value = operand.getImm();
+    }
+    key = mix64(mix64(key ^ tag) ^ value);
+  }
+  return key;
+}
+
+template <typename F> static void run_pool(uint64_t n, unsigned threads, F Fn) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  std::atomic<uint64_t> next{0};
+  auto worker = [&]() {
+    for (uint64_t i = next++; i < n; i = next++)
+      Fn(i);
+  };
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; ++t)
+    pool.emplace_back(worker);
+  for (auto &thread : pool)
+    thread.join();
+}
+
+static std::vector<FunctionSequence>
+collect_sequences(InstInfoContainer &insts, const ProgramPartition &partition,
+                  unsigned threads) {
+  std::vector<FunctionSequence> res(partition.functions.size());
+  run_pool(res.size(), threads, [&](uint64_t f) {
+    FunctionSequence &sequence = res[f];
+    sequence.entries = function_instructions(insts, partition, f);
+    sequence.hash = mix64(sequence.entries.size());
+    for (uint64_t i : sequence.entries) {
+      sequence.keys.push_back(instruction_key(insts, i));
+      sequence.hash = mix64(sequence.hash ^ sequence.keys.back());
+    }
+  });
+  return res;
+}
+
+// Myers' O(ND) shortest edit script. Returns false if more than max_edits
+// edits are needed.
+static bool diff_sequences(const FunctionSequence &a,
+                           const FunctionSequence &b, uint64_t max_edits,
+                           std::vector<DiffEdit> &edits) {
+  int64_t n = a.keys.size(), m = b.keys.size();
+  int64_t limit = std::min<int64_t>(n + m, max_edits);
+  // v[k + offset] is the furthest x on diagonal k; trace[d] keeps the
+  // diagonals -d..d as they were before step d.
+  int64_t offset = limit + 1;
+  std::vector<int64_t> v(2 * offset + 1, 0);
+  std::vector<std::vector<int64_t>> trace;
+  int64_t found = -1;
+  for (int64_t d = 0; d <= limit && found < 0; ++d) {
+    trace.emplace_back(v.begin() + offset - d, v.begin() + offset + d + 1);
+    for (int64_t k = -d; k <= d; k += 2) {
+      int64_t x = (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]))
+                      ? v[offset + k + 1]
+                      : v[offset + k - 1] + 1;
+      int64_t y = x - k;
+      while (x < n && y < m && a.keys[x] == b.keys[y])
+        ++x, ++y;
+      v[offset + k] = x;
+      if (x >= n && y >= m) {
+        found = d;
+        break;
+      }
+    }
+  }
+  if (found < 0)
+    return false;
+
+  int64_t x = n, y = m;
+  for (int64_t d = found; d >= 0; --d) {
+    // Diagonal k of the snapshot of step d lives at index k + d.
+    auto at = [&](int64_t k) { return trace[d][k + d]; };
+    int64_t k = x - y;
+    int64_t prev_k =
+        (k == -d || (k != d && at(k - 1) < at(k + 1))) ? k + 1 : k - 1;
+    int64_t prev_x = d == 0 ? 0 : at(prev_k);
+    int64_t prev_y = d == 0 ? 0 : prev_x - prev_k;
+    while (x > prev_x && y > prev_y) {
+      --x, --y;
+      edits.push_back({DiffOp::Equal, a.entries[x], b.entries[y]});
+    }
+    if (d == 0)
+      break;
+    if (x == prev_x)
+      edits.push_back({DiffOp::Insert, DiffEdit::NoEntry, b.entries[--y]});
+    else
+      edits.push_back({DiffOp::Delete, a.entries[--x], DiffEdit::NoEntry});
+  }
+  std::reverse(edits.begin(), edits.end());
+  return true;
+}
+
+static std::vector<DiffEdit> diff_pair(const FunctionSequence &a,
+                                       const FunctionSequence &b,
+                                       uint64_t max_edits) {
+  std::vector<DiffEdit> edits;
+  if (a.keys == b.keys || diff_sequences(a, b, max_edits, edits))
+    return edits;
+  edits.clear();
+  for (uint64_t i : a.entries)
+    edits.push_back({DiffOp::Delete, i, DiffEdit::NoEntry});
+  for (uint64_t i : b.entries)
+    edits.push_back({DiffOp::Insert, DiffEdit::NoEntry, i});
+  return edits;
+}
+} // namespace
+
+std::vector<uint64_t> function_instructions(const InstInfoContainer &insts,
+                                            const ProgramPartition &partition,
+                                            uint64_t function) {
+  const FunctionInfo &info = partition.functions[function];
+  std::vector<const BasicBlockInfo *> blocks;
+  for (uint64_t k = 0; k < info.num_blocks; ++k)
+    blocks.push_back(
+        &partition.blocks[partition.function_blocks[info.first_block + k]]);
+  std::sort(blocks.begin(), blocks.end(),
+            [](const BasicBlockInfo *a, const BasicBlockInfo *b) {
+              return a->start < b->start;
+            });
+  std::vector<uint64_t> res;
+  for (const BasicBlockInfo *block : blocks) {
+    uint64_t i = block->first;
+    for (uint32_t n = 0; n < block->num_insts; ++n) {
+      res.push_back(i);
+      i = (i * insts.step_size + insts.sizes[i]) / insts.step_size;
+    }
+  }
+  return res;
+}
+
+BinaryDiff diff_programs(InstInfoContainer &old_insts,
+                         const ProgramPartition &old_partition,
+                         InstInfoContainer &new_insts,
+                         const ProgramPartition &new_partition,
+                         uint64_t max_edits, unsigned threads) {
+  auto old_sequences = collect_sequences(old_insts, old_partition, threads);
+  auto new_sequences = collect_sequences(new_insts, new_partition, threads);
+  uint64_t num_old = old_sequences.size(), num_new = new_sequences.size();
+  const uint64_t NoMatch = ~uint64_t(0);
+  std::vector<uint64_t> old_match(num_old, NoMatch);
+  std::vector<uint64_t> new_match(num_new, NoMatch);
+  std::vector<uint8_t> old_kind(num_old);
+
+  // Hashes occurring exactly once in both builds.
+  std::unordered_map<uint64_t, std::pair<int64_t, int64_t>> by_hash;
+  for (uint64_t f = 0; f < num_old; ++f) {
+    auto &slot = by_hash[old_sequences[f].hash];
+    slot.first = slot.first ? -1 : int64_t(f) + 1;
+  }
+  for (uint64_t g = 0; g < num_new; ++g) {
+    auto &slot = by_hash[new_sequences[g].hash];
+    slot.second = slot.second ? -1 : int64_t(g) + 1;
+  }
+  for (auto &[hash, slot] : by_hash) {
+    if (slot.first <= 0 || slot.second <= 0)
+      continue;
+    old_match[slot.first - 1] = slot.second - 1;
+    new_match[slot.second - 1] = slot.first - 1;
+    old_kind[slot.first - 1] = MatchKind::Hash;
+  }
+
+  // Functions are in address order; pair the unmatched ones by rank inside
+  // each gap between consecutive hash matches that keep their order.
+  uint64_t f = 0, g = 0;
+  while (f < num_old && g < num_new) {
+    uint64_t f_end = f, g_end = g;
+    while (f_end < num_old && old_match[f_end] == NoMatch)
+      ++f_end;
+    while (g_end < num_new && new_match[g_end] == NoMatch)
+      ++g_end;
+    bool ordered = f_end == num_old || g_end == num_new ||
+                   old_match[f_end] == g_end;
+    for (; ordered && f < f_end && g < g_end; ++f, ++g) {
+      old_match[f] = g;
+      new_match[g] = f;
+      old_kind[f] = MatchKind::Position;
+    }
+    if (f_end == num_old || g_end == num_new)
+      break;
+    if (ordered) {
+      f = f_end + 1;
+      g = g_end + 1;
+    } else if (old_match[f_end] < g_end) {
+      // The old anchor pairs with a function already passed; skip it.
+      f = f_end + 1;
+    } else {
+      g = g_end + 1;
+    }
+  }
+
+  BinaryDiff res;
+  for (uint64_t f = 0; f < num_old; ++f) {
+    if (old_match[f] == NoMatch)
+      res.removed.push_back(f);
+    else
+      res.matches.push_back({f, old_match[f], old_kind[f], {}});
+  }
+  for (uint64_t g = 0; g < num_new; ++g)
+    if (new_match[g] == NoMatch)
+      res.added.push_back(g);
+  run_pool(res.matches.size(), threads, [&](uint64_t m) {
+    FunctionDiff &match = res.matches[m];
+    match.edits = diff_pair(old_sequences[match.old_function],
+                            new_sequences[match.new_function], max_edits);
+  });
+  return res;
+}
+} // namespace gapstone
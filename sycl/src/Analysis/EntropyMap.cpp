@@ -0,0 +1,162 @@
+#include "Analysis/EntropyMap.h"
+#include "Analysis/Superset.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace gapstone {
+EntropyMap entropy_map(sycl::queue &q, const uint8_t *content, uint64_t size,
+                       uint64_t window, const SupersetView *view) {
+  if (window == 0)
+    throw std::invalid_argument("Entropy windows must hold at least one byte");
+  EntropyMap res;
+  res.window = window;
+  uint64_t windows = (size + window - 1) / window;
+  res.entropy.resize(windows);
+  if (view)
+    res.density.resize(windows);
+  if (windows == 0)
+    return res;
+
+  bool has_view = view != nullptr;
+  SupersetView superset = has_view ? *view : SupersetView{};
+  float *entropy = sycl::malloc_device<float>(windows, q);
+  float *density = sycl::malloc_device<float>(windows, q);
+  q.submit([&](sycl::handler &h) {
+     sycl::local_accessor<uint32_t, 1> counts(256, h);
+     h.parallel_for(
+         sycl::nd_range<1>(windows * EntropyGroupSize, EntropyGroupSize),
+         [=](sycl::nd_item<1> item) {
+           uint64_t w = item.get_group_linear_id();
+           uint64_t lid = item.get_local_id(0);
+           uint64_t begin = w * window;
+           uint64_t end = sycl::min(begin + window, size);
+           for (uint64_t b = lid; b < 256; b += EntropyGroupSize)
+             counts[b] = 0;
+           sycl::group_barrier(item.get_group());
+           uint32_t slots = 0, decoded = 0;
+           for (uint64_t o = begin + lid; o < end; o += EntropyGroupSize) {
+             sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed,
+                              sycl::memory_scope::work_group,
+                              sycl::access::address_space::local_space>
+                 count(counts[content[o]]);
+             count.fetch_add(1);
+             if (!has_view || o % superset.step_size)
+               continue;
+             uint64_t i = o / superset.step_size;
+             if (i >= superset.tasks)
+               continue;
+             ++slots;
+             decoded += superset.valid(i);
+           }
+           sycl::group_barrier(item.get_group());
+           float term = 0.0f;
+           for (uint64_t b = lid; b < 256; b += EntropyGroupSize) {
+             if (!counts[b])
+               continue;
+             float p = float(counts[b]) / float(end - begin);
+             term -= p * sycl::log2(p);
+           }
+           float bits = sycl::reduce_over_group(item.get_group(), term,
+                                                sycl::plus<float>());
+           slots = sycl::reduce_over_group(item.get_group(), slots,
+                                           sycl::plus<uint32_t>());
+           decoded = sycl::reduce_over_group(item.get_group(), decoded,
+                                             sycl::plus<uint32_t>());
+           if (lid != 0)
+             return;
+           entropy[w] = bits;
+           density[w] = slots ? float(decoded) / float(slots) : 0.0f;
+         });
+   }).wait();
+  q.memcpy(res.entropy.data(), entropy, windows * sizeof(float));
+  if (has_view)
+    q.memcpy(res.density.data(), density, windows * sizeof(float));
+  q.wait();
+  sycl::free(density, q);
+  sycl::free(entropy, q);
+  return res;
+}
+
+EntropyMap entropy_map(sycl::queue &q, const std::vector<uint8_t> &content,
+                       uint64_t window) {
+  uint8_t *device_content = sycl::malloc_device<uint8_t>(content.size(), q);
+  q.memcpy(device_content, content.data(), content.size()).wait();
+  auto res = entropy_map(q, device_content, content.size(), window, nullptr);
+  sycl::free(device_content, q);
+  return res;
+}
+
+EntropyMap entropy_map(sycl::queue &q, const InstInfoContainer &insts,
+                       const std::vector<uint8_t> &content, uint64_t window) {
+  DeviceSuperset superset(q, insts);
+  SupersetView view = superset.view();
+  uint8_t *device_content = sycl::malloc_device<uint8_t>(content.size(), q);
+  q.memcpy(device_content, content.data(), content.size()).wait();
+  auto res = entropy_map(q, device_content, content.size(), window, &view);
+  sycl::free(device_content, q);
+  return res;
+}
+
+std::vector<uint8_t> decodable_windows(const EntropyMap &map,
+                                       float max_entropy, float min_density) {
+  std::vector<uint8_t> res(map.num_windows());
+  for (uint64_t w = 0; w < res.size(); ++w)
+    res[w] = map.entropy[w] <= max_entropy &&
+             (map.density.empty() || map.density[w] >= min_density);
+  return res;
+}
+
+std::vector<DecodeRange>
+decodable_ranges(const EntropyMap &map, const std::vector<uint8_t> &windows,
+                 const std::vector<DecodeRange> &ranges, int step_size) {
+  std::vector<DecodeRange> res;
+  for (const DecodeRange &range : ranges) {
+    uint64_t end = range.offset + range.size;
+    uint64_t begin = range.offset;
+    while (begin < end) {
+      // The run of windows from begin sharing its flag.
+      uint64_t w = begin / map.window;
+      bool flagged = w < windows.size() && windows[w];
+      uint64_t last = w;
+      while (last + 1 < windows.size() && windows[last + 1] == flagged &&
+             (last + 1) * map.window < end)
+        ++last;
+      uint64_t edge = (last + 1) * map.window;
+      uint64_t run_end =
+          std::min(end, (edge + step_size - 1) / step_size * step_size);
+      if (flagged)
+        res.push_back({range.address + (begin - range.offset), begin,
+                       run_end - begin});
+      begin = run_end;
+    }
+  }
+  return res;
+}
+
+void write_heatmap(std::ostream &os, const EntropyMap &map,
+                   uint64_t base_addr,
+                   const std::vector<DecodeRange> &ranges) {
+  static const char Shades[] = " .:-=+*#%@";
+  constexpr uint64_t WindowsPerLine = 64;
+  auto shade = [](float value) {
+    int level = int(value * 10.0f);
+    return Shades[std::clamp(level, 0, 9)];
+  };
+  for (uint64_t first = 0; first < map.num_windows();
+       first += WindowsPerLine) {
+    uint64_t last = std::min(first + WindowsPerLine, map.num_windows());
+    os << "0x" << std::hex
+       << range_address(ranges.data(), ranges.size(), base_addr,
+                        first * map.window)
+       << std::dec << " |";
+    for (uint64_t w = first; w < last; ++w)
+      os << shade(map.entropy[w] / 8.0f);
+    if (!map.density.empty()) {
+      os << "| |";
+      for (uint64_t w = first; w < last; ++w)
+        os << shade(map.density[w]);
+    }
+    os << "|\n";
+  }
+}
+} // namespace gapstone
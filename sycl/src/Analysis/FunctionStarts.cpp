@@ -0,0 +1,53 @@
+#include "Analysis/FunctionStarts.h"
+#include "Analysis/Primitives.h"
+#include "Analysis/Superset.h"
+#include <algorithm>
+
+namespace gapstone {
+sycl::event mark_call_targets(sycl::queue &q, const SupersetView &view,
+                              uint32_t *hints) {
+  return q.parallel_for(view.tasks, [=](sycl::id<1> i) {
+    if (!view.valid(i) || view.target_kinds[i] != TargetKind::Call)
+      return;
+    uint64_t target = view.index_of(view.targets[i]);
+    if (target == view.tasks || !view.valid(target))
+      return;
+    sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed,
+                     sycl::memory_scope::device>
+        hint(hints[target]);
+    hint.fetch_or(FunctionHint::CallTarget);
+  });
+}
+
+std::vector<FunctionCandidate>
+collect_function_candidates(sycl::queue &q, const SupersetView &view,
+                            const uint32_t *hints, uint32_t min_score) {
+  uint8_t *selected = sycl::malloc_device<uint8_t>(view.tasks, q);
+  q.parallel_for(view.tasks, [=](sycl::id<1> i) {
+     selected[i] =
+         view.valid(i) && function_hint_score(hints[i]) >= min_score;
+   }).wait();
+  uint64_t count;
+  uint64_t *indices = compact_indices(q, selected, view.tasks, count);
+  FunctionCandidate *candidates =
+      sycl::malloc_device<FunctionCandidate>(count, q);
+  q.parallel_for(count, [=](sycl::id<1> i) {
+     uint64_t index = indices[i];
+     candidates[i] = {view.address(index), function_hint_score(hints[index]),
+                      hints[index]};
+   }).wait();
+  std::vector<FunctionCandidate> res(count);
+  q.memcpy(res.data(), candidates, count * sizeof(FunctionCandidate)).wait();
+  sycl::free(candidates, q);
+  sycl::free(indices, q);
+  sycl::free(selected, q);
+  return res;
+}
+
+void rank_function_candidates(std::vector<FunctionCandidate> &candidates) {
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const FunctionCandidate &a, const FunctionCandidate &b) {
+                     return a.score > b.score;
+                   });
+}
+} // namespace gapstone
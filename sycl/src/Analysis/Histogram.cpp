@@ -0,0 +1,204 @@
+#include "Analysis/Histogram.h"
+#include "Analysis/Primitives.h"
+#include "Analysis/Superset.h"
+#include <algorithm>
+#include <cassert>
+
+namespace gapstone {
+namespace {
+constexpr uint32_t NoBin = ~uint32_t(0);
+
+// Work-group share of the entries of one group.
+struct HistogramChunk {
+  uint32_t group;
+  uint64_t begin;
+  uint64_t end;
+};
+
+// Bin of the n-gram starting at entry i, or NoBin.
+static uint32_t get_bin(const SupersetView &view, const uint32_t *group_of,
+                        uint64_t i, unsigned ngram, uint32_t num_bins) {
+  if (ngram == 1)
+    return view.opcodes[i] < num_bins ? view.opcodes[i] : NoBin;
+  uint64_t h = mix64(ngram);
+  uint64_t j = i;
+  for (unsigned k = 0;; ++k) {
+    h = mix64(h ^ view.opcodes[j]);
+    if (k + 1 == ngram)
+      break;
+    if (view.ends_flow(j))
+      return NoBin;
+    j = view.next(j);
+    if (j == view.tasks || group_of[j] != group_of[i])
+      return NoBin;
+  }
+  return uint32_t(h % num_bins);
+}
+} // namespace
+
+FeatureHistograms feature_histograms(sycl::queue &q, const SupersetView &view,
+                                     const uint32_t *group_of,
+                                     uint32_t num_groups, unsigned ngram,
+                                     uint32_t num_bins) {
+  assert(ngram >= 1 && ngram <= MaxNgram && "Unsupported n-gram order");
+  FeatureHistograms res;
+  res.num_groups = num_groups;
+  res.num_bins = num_bins;
+  uint64_t n = uint64_t(num_groups) * num_bins;
+  res.counts.resize(n);
+  uint64_t tasks = view.tasks;
+  if (n == 0 || tasks == 0)
+    return res;
+
+  // Entries grouped by group, in compressed sparse row form.
+  uint64_t *offsets = sycl::malloc_device<uint64_t>(num_groups + 1, q);
+  q.memset(offsets, 0, (num_groups + 1) * sizeof(uint64_t)).wait();
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     if (group_of[i] == NoGroup)
+       return;
+     sycl::atomic_ref<uint64_t, sycl::memory_order::relaxed,
+                      sycl::memory_scope::device>
+         count(offsets[group_of[i]]);
+     count.fetch_add(1);
+   }).wait();
+  uint64_t total = exclusive_scan(q, offsets, offsets, num_groups + 1);
+  uint64_t *cursors = sycl::malloc_device<uint64_t>(num_groups, q);
+  uint64_t *entries = sycl::malloc_device<uint64_t>(total, q);
+  q.memcpy(cursors, offsets, num_groups * sizeof(uint64_t)).wait();
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     if (group_of[i] == NoGroup)
+       return;
+     sycl::atomic_ref<uint64_t, sycl::memory_order::relaxed,
+                      sycl::memory_scope::device>
+         cursor(cursors[group_of[i]]);
+     entries[cursor.fetch_add(1)] = i;
+   }).wait();
+
+  std::vector<uint64_t> group_offsets(num_groups + 1);
+  q.memcpy(group_offsets.data(), offsets,
+           (num_groups + 1) * sizeof(uint64_t))
+      .wait();
+  std::vector<HistogramChunk> host_chunks;
+  for (uint32_t g = 0; g < num_groups; ++g)
+    for (uint64_t begin = group_offsets[g]; begin < group_offsets[g + 1];
+         begin += HistogramChunkSize)
+      host_chunks.push_back({g, begin,
+                             std::min(begin + HistogramChunkSize,
+                                      group_offsets[g + 1])});
+  uint64_t num_chunks = host_chunks.size();
+  HistogramChunk *chunks = sycl::malloc_device<HistogramChunk>(num_chunks, q);
+  uint32_t *counts = sycl::malloc_device<uint32_t>(n, q);
+  q.memcpy(chunks, host_chunks.data(), num_chunks * sizeof(HistogramChunk));
+  q.memset(counts, 0, n * sizeof(uint32_t));
+  q.wait();
+
+  if (num_chunks) {
+    q.submit([&](sycl::handler &h) {
+       sycl::local_accessor<uint32_t, 1> local(HistogramLocalBins, h);
+       h.parallel_for(
+           sycl::nd_range<1>(num_chunks * HistogramGroupSize,
+                             HistogramGroupSize),
+           [=](sycl::nd_item<1> item) {
+             HistogramChunk chunk = chunks[item.get_group_linear_id()];
+             uint64_t lid = item.get_local_id(0);
+             uint32_t *histogram = counts + uint64_t(chunk.group) * num_bins;
+             for (uint32_t base = 0; base < num_bins;
+                  base += HistogramLocalBins) {
+               uint32_t width = sycl::min(HistogramLocalBins, num_bins - base);
+               for (uint32_t b = lid; b < width; b += HistogramGroupSize)
+                 local[b] = 0;
+               sycl::group_barrier(item.get_group());
+               for (uint64_t e = chunk.begin + lid; e < chunk.end;
+                    e += HistogramGroupSize) {
+                 uint32_t bin =
+                     get_bin(view, group_of, entries[e], ngram, num_bins);
+                 if (bin == NoBin || bin < base || bin - base >= width)
+                   continue;
+                 sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed,
+                                  sycl::memory_scope::work_group,
+                                  sycl::access::address_space::local_space>
+                     slot(local[bin - base]);
+                 slot.fetch_add(1);
+               }
+               sycl::group_barrier(item.get_group());
+               for (uint32_t b = lid; b < width; b += HistogramGroupSize) {
+                 if (!local[b])
+                   continue;
+                 sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed,
+                                  sycl::memory_scope::device>
+                     slot(histogram[base + b]);
+                 slot.fetch_add(local[b]);
+               }
+               sycl::group_barrier(item.get_group());
+             }
+           });
+     }).wait();
+  }
+  q.memcpy(res.counts.data(), counts, n * sizeof(uint32_t)).wait();
+  sycl::free(counts, q);
+  sycl::free(chunks, q);
+  sycl::free(entries, q);
+  sycl::free(cursors, q);
+  sycl::free(offsets, q);
+  return res;
+}
+
+FeatureHistograms section_histograms(sycl::queue &q,
+                                     const InstInfoContainer &insts,
+                                     const std::vector<uint8_t> &mask,
+                                     unsigned ngram, uint32_t num_bins) {
+  DeviceSuperset superset(q, insts);
+  SupersetView view = superset.view();
+  uint8_t *selected = nullptr;
+  if (!mask.empty()) {
+    selected = sycl::malloc_device<uint8_t>(view.tasks, q);
+    q.memcpy(selected, mask.data(), view.tasks).wait();
+  }
+  uint32_t *group_of = sycl::malloc_device<uint32_t>(view.tasks, q);
+  q.parallel_for(view.tasks, [=](sycl::id<1> i) {
+     uint64_t offset = i * view.step_size;
+     uint64_t r = range_at(view.ranges, view.num_ranges, offset);
+     bool inside = !view.num_ranges ||
+                   offset - view.ranges[r].offset < view.ranges[r].size;
+     group_of[i] = view.valid(i) && (!selected || selected[i]) && inside
+                       ? uint32_t(r)
+                       : NoGroup;
+   }).wait();
+  uint32_t num_groups = view.num_ranges ? uint32_t(view.num_ranges) : 1;
+  auto res =
+      feature_histograms(q, view, group_of, num_groups, ngram, num_bins);
+  sycl::free(group_of, q);
+  if (selected)
+    sycl::free(selected, q);
+  return res;
+}
+
+FeatureHistograms function_histograms(sycl::queue &q,
+                                      const InstInfoContainer &insts,
+                                      const ProgramPartition &partition,
+                                      unsigned ngram, uint32_t num_bins) {
+  DeviceSuperset superset(q, insts);
+  SupersetView view = superset.view();
+  uint64_t num_blocks = partition.blocks.size();
+  std::vector<uint32_t> function_of(num_blocks);
+  for (uint64_t b = 0; b < num_blocks; ++b)
+    function_of[b] = partition.blocks[b].function;
+  uint64_t *block_of = sycl::malloc_device<uint64_t>(view.tasks, q);
+  uint32_t *functions = sycl::malloc_device<uint32_t>(num_blocks, q);
+  uint32_t *group_of = sycl::malloc_device<uint32_t>(view.tasks, q);
+  q.memcpy(block_of, partition.block_of.data(), view.tasks * sizeof(uint64_t));
+  q.memcpy(functions, function_of.data(), num_blocks * sizeof(uint32_t));
+  q.wait();
+  q.parallel_for(view.tasks, [=](sycl::id<1> i) {
+     uint64_t b = block_of[i];
+     group_of[i] = b == ProgramPartition::NoBlock ? NoGroup : functions[b];
+   }).wait();
+  auto res = feature_histograms(q, view, group_of,
+                                uint32_t(partition.functions.size()), ngram,
+                                num_bins);
+  sycl::free(group_of, q);
+  sycl::free(functions, q);
+  sycl::free(block_of, q);
+  return res;
+}
+} // namespace gapstone
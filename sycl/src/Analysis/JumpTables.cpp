@@ -0,0 +1,203 @@
+#include "Analysis/JumpTables.h"
+#include "Analysis/ControlFlow.h"
+#include "Analysis/Primitives.h"
+#include "Analysis/Superset.h"
+#include <algorithm>
+
+namespace gapstone {
+std::vector<uint64_t> collect_indirect_jumps(sycl::queue &q,
+                                             const InstInfoContainer &insts,
+                                             const std::vector<uint8_t> &mask) {
+  DeviceSuperset superset(q, insts);
+  SupersetView view = superset.view();
+  uint8_t *selected = nullptr;
+  if (!mask.empty()) {
+    selected = sycl::malloc_device<uint8_t>(view.tasks, q);
+    q.memcpy(selected, mask.data(), view.tasks).wait();
+  }
+  uint8_t *jumps = sycl::malloc_device<uint8_t>(view.tasks, q);
+  q.parallel_for(view.tasks, [=](sycl::id<1> i) {
+     jumps[i] = view.valid(i) && (!selected || selected[i]) &&
+                view.indirect_jump(i);
+   }).wait();
+  uint64_t count;
+  uint64_t *indices = compact_indices(q, jumps, view.tasks, count);
+  std::vector<uint64_t> res(count);
+  q.memcpy(res.data(), indices, count * sizeof(uint64_t)).wait();
+  sycl::free(indices, q);
+  sycl::free(jumps, q);
+  if (selected)
+    sycl::free(selected, q);
+  return res;
+}
+
+std::vector<uint64_t> preceding_instructions(const SupersetView &view,
+                                             const std::vector<uint8_t> &mask,
+                                             uint64_t i, unsigned window) {
+  // The longest instruction of any supported target.
+  constexpr uint64_t MaxInstSize = 15;
+  std::vector<uint64_t> res;
+  while (res.size() < window) {
+    uint64_t prev = view.tasks;
+    for (uint64_t d = 1; d * view.step_size <= MaxInstSize && d <= i; ++d) {
+      uint64_t j = i - d;
+      if (!view.valid(j) || view.next(j) != i || view.ends_flow(j))
+        continue;
+      if (mask.empty() || mask[j]) {
+        prev = j;
+        break;
+      }
+      if (prev == view.tasks)
+        prev = j;
+    }
+    if (prev == view.tasks)
+      break;
+    res.push_back(prev);
+    i = prev;
+  }
+  return res;
+}
+
+bool jump_table_target(const JumpTable &table,
+                       const std::vector<DataRegion> &regions, uint64_t k,
+                       uint64_t &target) {
+  uint64_t address = table.table + k * table.entry_size;
+  for (const DataRegion &region : regions) {
+    if (address < region.address ||
+        address - region.address + table.entry_size > region.size)
+      continue;
+    const uint8_t *p = region.data + (address - region.address);
+    uint64_t entry = 0;
+    for (unsigned b = 0; b < table.entry_size; ++b)
+      entry |= uint64_t(p[b]) << (8 * b);
+    if (table.encoding == JumpTableEncoding::Absolute) {
+      target = entry;
+      return true;
+    }
+    // Sign-extend the entry before scaling it.
+    unsigned bits = 8 * table.entry_size;
+    int64_t offset = bits == 64 ? int64_t(entry)
+                                : int64_t(entry << (64 - bits)) >> (64 - bits);
+    target = table.base + uint64_t(offset) * (uint64_t(1) << table.shift);
+    return true;
+  }
+  return false;
+}
+
+void validate_jump_tables(sycl::queue &q, const SupersetView &view,
+                          const uint8_t *mask,
+                          const std::vector<DataRegion> &regions,
+                          std::vector<JumpTable> &tables,
+                          uint32_t max_entries) {
+  uint64_t n = tables.size() * max_entries;
+  if (n == 0)
+    return;
+  // Entries are read on the host, where the data regions live. Unreadable
+  // entries keep 0, the table length already stops before them.
+  std::vector<uint64_t> entries(n, 0);
+  std::vector<uint32_t> limits(tables.size(), max_entries);
+  for (uint64_t t = 0; t < tables.size(); ++t)
+    for (uint32_t k = 0; k < max_entries; ++k)
+      if (!jump_table_target(tables[t], regions, k,
+                             entries[t * max_entries + k])) {
+        limits[t] = k;
+        break;
+      }
+
+  uint64_t *targets = sycl::malloc_device<uint64_t>(n, q);
+  uint32_t *lengths = sycl::malloc_device<uint32_t>(tables.size(), q);
+  q.memcpy(targets, entries.data(), n * sizeof(uint64_t)).wait();
+  q.memcpy(lengths, limits.data(), limits.size() * sizeof(uint32_t)).wait();
+  q.parallel_for(n, [=](sycl::id<1> i) {
+     uint64_t index = view.index_of(targets[i]);
+     if (index != view.tasks && view.valid(index) && (!mask || mask[index]))
+       return;
+     sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed,
+                      sycl::memory_scope::device>
+         length(lengths[i / max_entries]);
+     length.fetch_min(uint32_t(i % max_entries));
+   }).wait();
+  q.memcpy(limits.data(), lengths, limits.size() * sizeof(uint32_t)).wait();
+  sycl::free(lengths, q);
+  sycl::free(targets, q);
+
+  for (uint64_t t = 0; t < tables.size(); ++t)
+    tables[t].num_entries = limits[t];
+  tables.erase(std::remove_if(tables.begin(), tables.end(),
+                              [](const JumpTable &table) {
+                                return table.num_entries == 0;
+                              }),
+               tables.end());
+}
+
+void validate_jump_tables(sycl::queue &q, const InstInfoContainer &insts,
+                          const std::vector<uint8_t> &mask,
+                          const std::vector<DataRegion> &regions,
+                          std::vector<JumpTable> &tables,
+                          uint32_t max_entries) {
+  DeviceSuperset superset(q, insts);
+  uint8_t *selected = nullptr;
+  if (!mask.empty()) {
+    selected = sycl::malloc_device<uint8_t>(superset.tasks(), q);
+    q.memcpy(selected, mask.data(), superset.tasks()).wait();
+  }
+  validate_jump_tables(q, superset.view(), selected, regions, tables,
+                       max_entries);
+  if (selected)
+    sycl::free(selected, q);
+}
+
+void add_jump_table_edges(ControlFlowGraph &cfg,
+                          const std::vector<JumpTable> &tables,
+                          const std::vector<DataRegion> &regions) {
+  std::vector<std::pair<uint64_t, uint64_t>> extra;
+  for (const JumpTable &table : tables) {
+    uint64_t source = cfg.index_of(table.jump);
+    if (source >= cfg.num_vertices)
+      continue;
+    for (uint64_t k = 0; k < table.num_entries; ++k) {
+      uint64_t target;
+      if (!jump_table_target(table, regions, k, target))
+        continue;
+      uint64_t dest = cfg.index_of(target);
+      if (dest < cfg.num_vertices)
+        extra.push_back({source, dest});
+    }
+  }
+  std::sort(extra.begin(), extra.end());
+  extra.erase(std::unique(extra.begin(), extra.end()), extra.end());
+  if (extra.empty())
+    return;
+
+  std::vector<uint64_t> offsets(cfg.num_vertices + 1, 0);
+  std::vector<uint64_t> columns;
+  std::vector<uint8_t> kinds;
+  columns.reserve(cfg.num_edges() + extra.size());
+  kinds.reserve(cfg.num_edges() + extra.size());
+  auto it = extra.begin();
+  for (uint64_t v = 0; v < cfg.num_vertices; ++v) {
+    offsets[v] = columns.size();
+    uint64_t e = cfg.offsets[v], end = cfg.offsets[v + 1];
+    // Merge the sorted rows; an existing edge to the same destination wins.
+    while (e < end || (it != extra.end() && it->first == v)) {
+      bool take_extra = it != extra.end() && it->first == v &&
+                        (e == end || it->second < cfg.columns[e]);
+      if (take_extra) {
+        columns.push_back(it->second);
+        kinds.push_back(EdgeKind::JumpTable);
+        ++it;
+        continue;
+      }
+      if (it != extra.end() && it->first == v && it->second == cfg.columns[e])
+        ++it;
+      columns.push_back(cfg.columns[e]);
+      kinds.push_back(cfg.kinds[e]);
+      ++e;
+    }
+  }
+  offsets[cfg.num_vertices] = columns.size();
+  cfg.offsets = std::move(offsets);
+  cfg.columns = std::move(columns);
+  cfg.kinds = std::move(kinds);
+}
+} // namespace gapstone
@@ -0,0 +1,47 @@
+#include "Analysis/LinearSweep.h"
+#include "Analysis/Primitives.h"
+#include "Analysis/Superset.h"
+#include <utility>
+
+namespace gapstone {
+void linear_sweep(sycl::queue &q, const SupersetView &view, uint8_t *selected) {
+  uint64_t tasks = view.tasks;
+  if (tasks == 0)
+    return;
+  uint64_t *jump = sycl::malloc_device<uint64_t>(tasks, q);
+  uint64_t *jump_next = sycl::malloc_device<uint64_t>(tasks, q);
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     jump[i] = view.valid(i) ? view.next(i) : i + 1;
+     selected[i] = view.starts_range(i);
+   }).wait();
+  // After round k every entry up to 2^(k+1) - 1 hops from a start is
+  // selected and jump[i] is 2^(k+1) hops ahead of i. A selected entry is
+  // always on a chain, so flags set early within a round do no harm.
+  for (uint64_t hops = 1; hops < tasks; hops *= 2) {
+    q.parallel_for(tasks, [=](sycl::id<1> i) {
+       if (selected[i] && jump[i] < tasks)
+         selected[jump[i]] = 1;
+     }).wait();
+    q.parallel_for(tasks, [=](sycl::id<1> i) {
+       jump_next[i] = jump[i] < tasks ? jump[jump[i]] : tasks;
+     }).wait();
+    std::swap(jump, jump_next);
+  }
+  sycl::free(jump_next, q);
+  sycl::free(jump, q);
+}
+
+std::vector<uint64_t> linear_sweep(sycl::queue &q,
+                                   const InstInfoContainer &insts) {
+  DeviceSuperset superset(q, insts);
+  uint8_t *selected = sycl::malloc_device<uint8_t>(superset.tasks(), q);
+  linear_sweep(q, superset.view(), selected);
+  uint64_t count;
+  uint64_t *indices = compact_indices(q, selected, superset.tasks(), count);
+  std::vector<uint64_t> res(count);
+  q.memcpy(res.data(), indices, count * sizeof(uint64_t)).wait();
+  sycl::free(indices, q);
+  sycl::free(selected, q);
+  return res;
+}
+} // namespace gapstone
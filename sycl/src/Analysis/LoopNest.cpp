@@ -0,0 +1,139 @@
+#include "Analysis/LoopNest.h"
+#include <algorithm>
+#include <atomic>
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/dominator_tree.hpp>
+#include <thread>
+#include <unordered_map>
+
+namespace gapstone {
+typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::bidirectionalS>
+    BlockGraph;
+typedef boost::graph_traits<BlockGraph>::vertex_descriptor BlockVertex;
+static const BlockVertex NoVertex =
+    boost::graph_traits<BlockGraph>::null_vertex();
+
+static void analyze_function(const ProgramPartition &partition,
+                             const ControlFlowGraph &cfg,
+                             const FunctionInfo &function, LoopNest &res) {
+  const uint64_t *blocks = &partition.function_blocks[function.first_block];
+  uint64_t n = function.num_blocks;
+  // Local vertex k stands for block blocks[k].
+  std::unordered_map<uint64_t, BlockVertex> local;
+  BlockVertex entry = 0;
+  for (uint64_t k = 0; k < n; ++k) {
+    local[blocks[k]] = k;
+    if (partition.blocks[blocks[k]].start == function.entry)
+      entry = k;
+  }
+  BlockGraph graph(n);
+  for (uint64_t k = 0; k < n; ++k) {
+    uint64_t last = partition.blocks[blocks[k]].last;
+    for (uint64_t e = cfg.offsets[last]; e < cfg.offsets[last + 1]; ++e) {
+      if (cfg.kinds[e] == EdgeKind::Call)
+        continue;
+      auto it = local.find(partition.block_of[cfg.columns[e]]);
+      if (it != local.end())
+        boost::add_edge(k, it->second, graph);
+    }
+  }
+
+  std::vector<BlockVertex> idom(n, NoVertex);
+  boost::lengauer_tarjan_dominator_tree(
+      graph, entry,
+      boost::make_iterator_property_map(
+          idom.begin(), boost::get(boost::vertex_index, graph)));
+  // Depth in the dominator tree, 0 for the entry and unreachable blocks.
+  std::vector<uint32_t> dom_depth(n, 0);
+  std::vector<uint8_t> done(n, 0);
+  auto reachable = [&](BlockVertex v) {
+    return v == entry || idom[v] != NoVertex;
+  };
+  for (uint64_t k = 0; k < n; ++k) {
+    std::vector<BlockVertex> chain;
+    BlockVertex v = k;
+    while (!done[v] && idom[v] != NoVertex) {
+      chain.push_back(v);
+      v = idom[v];
+    }
+    uint32_t depth = dom_depth[v];
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+      dom_depth[*it] = ++depth;
+      done[*it] = 1;
+    }
+    done[v] = 1;
+  }
+  auto dominates = [&](BlockVertex h, BlockVertex v) {
+    while (dom_depth[v] > dom_depth[h])
+      v = idom[v];
+    return v == h;
+  };
+
+  // Natural loops: the body of a back edge u -> h is everything that reaches
+  // u without passing through h. Back edges sharing a header form one loop.
+  std::vector<uint32_t> depth(n, 0);
+  std::vector<BlockVertex> innermost(n, n);
+  std::vector<uint8_t> in_loop(n);
+  for (BlockVertex h = 0; h < n; ++h) {
+    std::vector<BlockVertex> work;
+    boost::graph_traits<BlockGraph>::in_edge_iterator ei, ee;
+    for (boost::tie(ei, ee) = boost::in_edges(h, graph); ei != ee; ++ei) {
+      BlockVertex u = boost::source(*ei, graph);
+      if (reachable(u) && dominates(h, u))
+        work.push_back(u);
+    }
+    if (work.empty())
+      continue;
+    std::fill(in_loop.begin(), in_loop.end(), 0);
+    in_loop[h] = 1;
+    std::vector<BlockVertex> body{h};
+    while (!work.empty()) {
+      BlockVertex v = work.back();
+      work.pop_back();
+      if (in_loop[v] || !reachable(v))
+        continue;
+      in_loop[v] = 1;
+      body.push_back(v);
+      for (boost::tie(ei, ee) = boost::in_edges(v, graph); ei != ee; ++ei)
+        work.push_back(boost::source(*ei, graph));
+    }
+    for (auto v : body) {
+      ++depth[v];
+      // Of two loops containing v, the one with the deeper header is nested
+      // inside the other.
+      if (innermost[v] == n || dom_depth[h] > dom_depth[innermost[v]])
+        innermost[v] = h;
+    }
+  }
+
+  for (uint64_t k = 0; k < n; ++k) {
+    uint64_t b = blocks[k];
+    res.idom[b] = idom[k] == NoVertex ? LoopNest::NoBlock : blocks[idom[k]];
+    res.loop_header[b] = innermost[k] == n ? LoopNest::NoBlock
+                                           : blocks[innermost[k]];
+    res.loop_depth[b] = depth[k];
+  }
+}
+
+LoopNest analyze_loop_nests(const ProgramPartition &partition,
+                            const ControlFlowGraph &cfg, unsigned threads) {
+  LoopNest res;
+  uint64_t num_blocks = partition.blocks.size();
+  res.idom.assign(num_blocks, LoopNest::NoBlock);
+  res.loop_header.assign(num_blocks, LoopNest::NoBlock);
+  res.loop_depth.assign(num_blocks, 0);
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  std::atomic<uint64_t> next{0};
+  auto worker = [&]() {
+    for (uint64_t f = next++; f < partition.functions.size(); f = next++)
+      analyze_function(partition, cfg, partition.functions[f], res);
+  };
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; ++t)
+    pool.emplace_back(worker);
+  for (auto &thread : pool)
+    thread.join();
+  return res;
+}
+} // namespace gapstone
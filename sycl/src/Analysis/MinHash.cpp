@@ -0,0 +1,179 @@
+#include "Analysis/MinHash.h"
+#include "Analysis/Primitives.h"
+#include "Analysis/Superset.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace gapstone {
+namespace {
+constexpr char Magic[4] = {'G', 'S', 'I', 'G'};
+constexpr uint32_t Version = 1;
+
+static uint64_t band_hash(uint32_t band, const uint32_t *values,
+                          uint32_t rows) {
+  uint64_t h = mix64(band + 1);
+  for (uint32_t r = 0; r < rows; ++r)
+    h = mix64(h ^ values[r]);
+  return h;
+}
+
+template <typename T> static void write_le(std::ostream &os, T value) {
+  for (unsigned b = 0; b < sizeof(T); ++b)
+    os.put(char((uint64_t(value) >> (8 * b)) & 0xff));
+}
+
+template <typename T> static T read_le(std::istream &is) {
+  uint64_t value = 0;
+  for (unsigned b = 0; b < sizeof(T); ++b) {
+    int c = is.get();
+    if (c == std::char_traits<char>::eof())
+      throw std::runtime_error("Truncated signature file");
+    value |= uint64_t(uint8_t(c)) << (8 * b);
+  }
+  return T(value);
+}
+} // namespace
+
+MinHashSignatures minhash_signatures(sycl::queue &q, const SupersetView &view,
+                                     const ProgramPartition &partition,
+                                     unsigned ngram, uint32_t num_hashes,
+                                     uint64_t seed) {
+  MinHashSignatures res;
+  res.num_hashes = num_hashes;
+  uint64_t num_functions = partition.functions.size();
+  uint64_t num_blocks = partition.blocks.size();
+  for (const FunctionInfo &function : partition.functions)
+    res.addresses.push_back(function.entry);
+  uint64_t n = num_functions * num_hashes;
+  res.values.resize(n);
+  if (n == 0 || view.tasks == 0)
+    return res;
+
+  std::vector<uint32_t> function_of(num_blocks);
+  std::vector<uint64_t> last_of(num_blocks);
+  for (uint64_t b = 0; b < num_blocks; ++b) {
+    function_of[b] = partition.blocks[b].function;
+    last_of[b] = partition.blocks[b].last;
+  }
+  uint64_t tasks = view.tasks;
+  uint64_t *block_of = sycl::malloc_device<uint64_t>(tasks, q);
+  uint32_t *functions = sycl::malloc_device<uint32_t>(num_blocks, q);
+  uint64_t *lasts = sycl::malloc_device<uint64_t>(num_blocks, q);
+  uint32_t *values = sycl::malloc_device<uint32_t>(n, q);
+  q.memcpy(block_of, partition.block_of.data(), tasks * sizeof(uint64_t));
+  q.memcpy(functions, function_of.data(), num_blocks * sizeof(uint32_t));
+  q.memcpy(lasts, last_of.data(), num_blocks * sizeof(uint64_t));
+  q.fill(values, std::numeric_limits<uint32_t>::max(), n);
+  q.wait();
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     uint64_t b = block_of[i];
+     if (b == ProgramPartition::NoBlock)
+       return;
+     uint64_t shingle = mix64(seed);
+     uint64_t j = i;
+     for (unsigned k = 0; k < ngram; ++k) {
+       shingle = mix64(shingle ^ view.opcodes[j]);
+       if (j == lasts[b])
+         break;
+       j = view.next(j);
+     }
+     uint32_t *signature = values + uint64_t(functions[b]) * num_hashes;
+     for (uint32_t k = 0; k < num_hashes; ++k) {
+       sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed,
+                        sycl::memory_scope::device>
+           value(signature[k]);
+       value.fetch_min(
+           uint32_t(mix64(shingle + (k + 1) * 0x9e3779b97f4a7c15ULL) >> 32));
+     }
+   }).wait();
+  q.memcpy(res.values.data(), values, n * sizeof(uint32_t)).wait();
+  sycl::free(values, q);
+  sycl::free(lasts, q);
+  sycl::free(functions, q);
+  sycl::free(block_of, q);
+  return res;
+}
+
+MinHashSignatures minhash_signatures(sycl::queue &q,
+                                     const InstInfoContainer &insts,
+                                     const ProgramPartition &partition,
+                                     unsigned ngram, uint32_t num_hashes,
+                                     uint64_t seed) {
+  DeviceSuperset superset(q, insts);
+  return minhash_signatures(q, superset.view(), partition, ngram, num_hashes,
+                            seed);
+}
+
+float estimate_similarity(const uint32_t *a, const uint32_t *b,
+                          uint32_t num_hashes) {
+  if (num_hashes == 0)
+    return 0.0f;
+  uint32_t equal = 0;
+  for (uint32_t k = 0; k < num_hashes; ++k)
+    equal += a[k] == b[k];
+  return float(equal) / float(num_hashes);
+}
+
+void write_minhash_signatures(std::ostream &os,
+                              const MinHashSignatures &signatures) {
+  os.write(Magic, sizeof(Magic));
+  write_le<uint32_t>(os, Version);
+  write_le<uint32_t>(os, signatures.num_hashes);
+  write_le<uint64_t>(os, signatures.size());
+  for (uint64_t f = 0; f < signatures.size(); ++f) {
+    write_le<uint64_t>(os, signatures.addresses[f]);
+    const uint32_t *signature = signatures.signature(f);
+    for (uint32_t k = 0; k < signatures.num_hashes; ++k)
+      write_le<uint32_t>(os, signature[k]);
+  }
+}
+
+MinHashSignatures read_minhash_signatures(std::istream &is) {
+  char magic[sizeof(Magic)];
+  if (!is.read(magic, sizeof(magic)) ||
+      !std::equal(magic, magic + sizeof(magic), Magic))
+    throw std::runtime_error("Not a signature file");
+  if (read_le<uint32_t>(is) != Version)
+    throw std::runtime_error("Unsupported signature file version");
+  MinHashSignatures res;
+  res.num_hashes = read_le<uint32_t>(is);
+  uint64_t count = read_le<uint64_t>(is);
+  for (uint64_t f = 0; f < count; ++f) {
+    res.addresses.push_back(read_le<uint64_t>(is));
+    for (uint32_t k = 0; k < res.num_hashes; ++k)
+      res.values.push_back(read_le<uint32_t>(is));
+  }
+  return res;
+}
+
+std::vector<uint64_t> LSHIndex::query(const uint32_t *signature) const {
+  std::vector<uint64_t> res;
+  for (uint32_t band = 0; band < bands; ++band) {
+    auto bucket =
+        buckets[band].find(band_hash(band, signature + band * rows, rows));
+    if (bucket != buckets[band].end())
+      res.insert(res.end(), bucket->second.begin(), bucket->second.end());
+  }
+  std::sort(res.begin(), res.end());
+  res.erase(std::unique(res.begin(), res.end()), res.end());
+  return res;
+}
+
+LSHIndex build_lsh_index(const MinHashSignatures &signatures, uint32_t bands) {
+  if (bands == 0 || signatures.num_hashes % bands)
+    throw std::invalid_argument("Bands must divide the signature length");
+  LSHIndex index;
+  index.bands = bands;
+  index.rows = signatures.num_hashes / bands;
+  index.buckets.resize(bands);
+  for (uint64_t f = 0; f < signatures.size(); ++f) {
+    const uint32_t *signature = signatures.signature(f);
+    for (uint32_t band = 0; band < bands; ++band)
+      index.buckets[band][band_hash(band, signature + band * index.rows,
+                                    index.rows)]
+          .push_back(f);
+  }
+  return index;
+}
+} // namespace gapstone
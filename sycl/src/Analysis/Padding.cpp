@@ -0,0 +1,270 @@
+#include "Analysis/Padding.h"
+#include "Analysis/Primitives.h"
+#include <algorithm>
+
+namespace gapstone {
+namespace {
+static bool is_fill(uint8_t byte) { return byte == 0x00 || byte == 0xCC; }
+
+// Length of the longest pattern matching at offset, or 0.
+static uint32_t nop_length(const uint8_t *content, uint64_t size,
+                           uint64_t offset, const uint8_t *bytes,
+                           const uint32_t *starts, uint32_t num_patterns) {
+  for (uint32_t p = 0; p < num_patterns; ++p) {
+    uint32_t length = starts[p + 1] - starts[p];
+    if (offset + length > size)
+      continue;
+    uint32_t k = 0;
+    while (k < length && content[offset + k] == bytes[starts[p] + k])
+      ++k;
+    if (k == length)
+      return length;
+  }
+  return 0;
+}
+
+static std::vector<std::vector<uint8_t>> x86_nops() {
+  std::vector<std::vector<uint8_t>> res = {
+      {0x90},
+      {0x66, 0x90},
+      {0x0f, 0x1f, 0x00},
+      {0x0f, 0x1f, 0x40, 0x00},
+      {0x0f, 0x1f, 0x44, 0x00, 0x00},
+      {0x66, 0x0f, 0x1f, 0x44, 0x00, 0x00},
+      {0x0f, 0x1f, 0x80, 0x00, 0x00, 0x00, 0x00},
+      {0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00},
+      {0x66, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00},
+  };
+  // data16 cs nopw with as many 0x66 prefixes as fit in 15 bytes.
+  std::vector<uint8_t> nopw = {0x2e, 0x0f, 0x1f, 0x84, 0x00,
+                               0x00, 0x00, 0x00, 0x00};
+  while (nopw.size() < MaxNopSize) {
+    nopw.insert(nopw.begin(), 0x66);
+    res.push_back(nopw);
+  }
+  std::stable_sort(res.begin(), res.end(),
+                   [](const auto &a, const auto &b) {
+                     return a.size() > b.size();
+                   });
+  return res;
+}
+} // namespace
+
+const std::vector<std::vector<uint8_t>> &
+nop_patterns(llvm::Triple::ArchType arch) {
+  static const std::vector<std::vector<uint8_t>> X86 = x86_nops();
+  static const std::vector<std::vector<uint8_t>> AArch64 = {
+      {0x1f, 0x20, 0x03, 0xd5}};
+  static const std::vector<std::vector<uint8_t>> LoongArch = {
+      {0x00, 0x00, 0x40, 0x03}};
+  static const std::vector<std::vector<uint8_t>> None;
+  switch (arch) {
+  case llvm::Triple::x86:
+  case llvm::Triple::x86_64:
+    return X86;
+  case llvm::Triple::aarch64:
+  case llvm::Triple::aarch64_be:
+    return AArch64;
+  case llvm::Triple::loongarch64:
+    return LoongArch;
+  default:
+    return None;
+  }
+}
+
+PaddingScan scan_padding(sycl::queue &q, const std::vector<uint8_t> &content,
+                         int step_size,
+                         const std::vector<std::vector<uint8_t>> &nops,
+                         uint64_t min_run) {
+  PaddingScan res;
+  uint64_t size = content.size();
+  uint64_t slots = size / step_size;
+  if (slots == 0)
+    return res;
+
+  std::vector<uint8_t> host_bytes;
+  std::vector<uint32_t> host_starts = {0};
+  for (auto &pattern : nops) {
+    host_bytes.insert(host_bytes.end(), pattern.begin(), pattern.end());
+    host_starts.push_back(host_bytes.size());
+  }
+  uint32_t num_patterns = nops.size();
+  uint8_t *data = sycl::malloc_device<uint8_t>(size, q);
+  uint8_t *bytes = sycl::malloc_device<uint8_t>(host_bytes.size() + 1, q);
+  uint32_t *starts = sycl::malloc_device<uint32_t>(host_starts.size(), q);
+  q.memcpy(data, content.data(), size);
+  q.memcpy(bytes, host_bytes.data(), host_bytes.size());
+  q.memcpy(starts, host_starts.data(), host_starts.size() * sizeof(uint32_t));
+  q.wait();
+
+  // First and last bytes of the 0x00/0xCC runs, and nop lengths.
+  uint8_t *heads = sycl::malloc_device<uint8_t>(size, q);
+  uint8_t *tails = sycl::malloc_device<uint8_t>(size, q);
+  uint32_t *nop_lengths = sycl::malloc_device<uint32_t>(size, q);
+  q.parallel_for(size, [=](sycl::id<1> i) {
+     uint8_t byte = data[i];
+     bool fill = is_fill(byte);
+     heads[i] = fill && (i == 0 || data[i - 1] != byte);
+     tails[i] = fill && (i + 1 == size || data[i + 1] != byte);
+     nop_lengths[i] = i % step_size ? 0
+                                    : nop_length(data, size, i, bytes, starts,
+                                                 num_patterns);
+   }).wait();
+
+  // Nop runs start at the nops no earlier nop falls through to or overlaps;
+  // each walks its chain, and marks the instruction starts of chains long
+  // enough.
+  uint8_t *nop_heads = sycl::malloc_device<uint8_t>(size, q);
+  uint8_t *nop_starts = sycl::malloc_device<uint8_t>(size, q);
+  uint64_t *nop_ends = sycl::malloc_device<uint64_t>(size, q);
+  q.memset(nop_starts, 0, size).wait();
+  q.parallel_for(size, [=](sycl::id<1> i) {
+     nop_heads[i] = 0;
+     if (!nop_lengths[i])
+       return;
+     for (uint64_t d = 1; d <= MaxNopSize && d <= i; ++d)
+       if (nop_lengths[i - d] >= d)
+         return;
+     uint64_t end = i;
+     while (end < size && nop_lengths[end])
+       end += nop_lengths[end];
+     if (end - i < min_run)
+       return;
+     nop_heads[i] = 1;
+     nop_ends[i] = end;
+     for (uint64_t e = i; e < end; e += nop_lengths[e])
+       nop_starts[e] = 1;
+   }).wait();
+
+  uint64_t num_fills, num_tails, num_nops;
+  uint64_t *fill_begins = compact_indices(q, heads, size, num_fills);
+  uint64_t *fill_lasts = compact_indices(q, tails, size, num_tails);
+  uint64_t *nop_begins = compact_indices(q, nop_heads, size, num_nops);
+
+  // Coverage of the runs: +1 at begin, -1 at end, scanned.
+  uint64_t *cover = sycl::malloc_device<uint64_t>(size + 1, q);
+  q.memset(cover, 0, (size + 1) * sizeof(uint64_t)).wait();
+  auto mark = [=](uint64_t begin, uint64_t end) {
+    sycl::atomic_ref<uint64_t, sycl::memory_order::relaxed,
+                     sycl::memory_scope::device>
+        up(cover[begin]), down(cover[end]);
+    up.fetch_add(1);
+    down.fetch_sub(1);
+  };
+  if (num_fills)
+    q.parallel_for(num_fills, [=](sycl::id<1> k) {
+       if (fill_lasts[k] + 1 - fill_begins[k] >= min_run)
+         mark(fill_begins[k], fill_lasts[k] + 1);
+     }).wait();
+  if (num_nops)
+    q.parallel_for(num_nops, [=](sycl::id<1> k) {
+       mark(nop_begins[k], nop_ends[nop_begins[k]]);
+     }).wait();
+  exclusive_scan(q, cover, cover, size + 1);
+
+  // A slot is skipped when its whole instruction lies in a run, unless it
+  // starts a nop of a nop run.
+  uint8_t *keep = sycl::malloc_device<uint8_t>(slots, q);
+  q.parallel_for(slots, [=](sycl::id<1> s) {
+     uint64_t offset = s * step_size;
+     bool covered = cover[offset + 1] && cover[offset + step_size];
+     keep[s] = !covered || nop_starts[offset];
+   }).wait();
+  uint64_t num_offsets;
+  uint64_t *offsets = compact_indices(q, keep, slots, num_offsets);
+  res.offsets.resize(num_offsets);
+  q.memcpy(res.offsets.data(), offsets, num_offsets * sizeof(uint64_t));
+
+  uint64_t *nop_run_ends = sycl::malloc_device<uint64_t>(num_nops, q);
+  if (num_nops)
+    q.parallel_for(num_nops, [=](sycl::id<1> k) {
+       nop_run_ends[k] = nop_ends[nop_begins[k]];
+     }).wait();
+  std::vector<uint64_t> host_begins(num_fills), host_lasts(num_fills),
+      host_nops(num_nops), host_nop_ends(num_nops);
+  q.memcpy(host_begins.data(), fill_begins, num_fills * sizeof(uint64_t));
+  q.memcpy(host_lasts.data(), fill_lasts, num_fills * sizeof(uint64_t));
+  q.memcpy(host_nops.data(), nop_begins, num_nops * sizeof(uint64_t));
+  q.memcpy(host_nop_ends.data(), nop_run_ends, num_nops * sizeof(uint64_t));
+  q.wait();
+  for (auto &offset : res.offsets)
+    offset *= step_size;
+  for (uint64_t k = 0; k < num_fills; ++k)
+    if (host_lasts[k] + 1 - host_begins[k] >= min_run)
+      res.runs.push_back({host_begins[k], host_lasts[k] + 1,
+                          content[host_begins[k]] == 0xCC ? PaddingKind::Int3
+                                                          : PaddingKind::Zero});
+  for (uint64_t k = 0; k < num_nops; ++k)
+    res.runs.push_back({host_nops[k], host_nop_ends[k], PaddingKind::Nop});
+  std::sort(res.runs.begin(), res.runs.end(),
+            [](const PaddingRun &a, const PaddingRun &b) {
+              return a.begin < b.begin;
+            });
+
+  sycl::free(nop_run_ends, q);
+  sycl::free(offsets, q);
+  sycl::free(keep, q);
+  sycl::free(cover, q);
+  sycl::free(nop_begins, q);
+  sycl::free(fill_lasts, q);
+  sycl::free(fill_begins, q);
+  sycl::free(nop_ends, q);
+  sycl::free(nop_starts, q);
+  sycl::free(nop_heads, q);
+  sycl::free(nop_lengths, q);
+  sycl::free(tails, q);
+  sycl::free(heads, q);
+  sycl::free(starts, q);
+  sycl::free(bytes, q);
+  sycl::free(data, q);
+  return res;
+}
+
+std::vector<PaddingRun>
+clip_padding_runs(const std::vector<PaddingRun> &runs,
+                  const std::vector<DecodeRange> &ranges) {
+  std::vector<PaddingRun> res;
+  for (const PaddingRun &run : runs)
+    for (uint64_t r = range_at(ranges.data(), ranges.size(), run.begin);
+         r < ranges.size() && ranges[r].offset < run.end; ++r) {
+      uint64_t begin = std::max(run.begin, ranges[r].offset);
+      uint64_t end = std::min(run.end, ranges[r].offset + ranges[r].size);
+      if (begin < end)
+        res.push_back({begin, end, run.kind});
+    }
+  return res;
+}
+
+std::vector<FunctionCandidate>
+padding_function_hints(const std::vector<PaddingRun> &runs,
+                       const std::vector<DecodeRange> &ranges,
+                       uint64_t alignment) {
+  std::vector<FunctionCandidate> res;
+  if (ranges.empty())
+    return res;
+  for (const PaddingRun &run : runs) {
+    const DecodeRange &range =
+        ranges[range_at(ranges.data(), ranges.size(), run.end)];
+    if (run.end < range.offset || run.end - range.offset >= range.size)
+      continue;
+    uint64_t address = range.address + (run.end - range.offset);
+    if (address % alignment)
+      continue;
+    res.push_back({address, function_hint_score(FunctionHint::AfterPadding),
+                   FunctionHint::AfterPadding});
+  }
+  // Runs of different kinds may end at the same address.
+  auto by_address = [](const FunctionCandidate &a,
+                       const FunctionCandidate &b) {
+    return a.address < b.address;
+  };
+  std::sort(res.begin(), res.end(), by_address);
+  res.erase(std::unique(res.begin(), res.end(),
+                        [](const FunctionCandidate &a,
+                           const FunctionCandidate &b) {
+                          return a.address == b.address;
+                        }),
+            res.end());
+  return res;
+}
+} // namespace gapstone
@@ -0,0 +1,196 @@
+#include "Analysis/Partition.h"
+#include "Analysis/Primitives.h"
+#include "Analysis/Superset.h"
+
+namespace gapstone {
+namespace {
+enum EntryFlag : uint32_t {
+  Leader = 1 << 0,
+  FallenInto = 1 << 1,
+  CallDestination = 1 << 2,
+};
+} // namespace
+
+static void set_flag(uint32_t *flags, uint64_t i, uint32_t flag) {
+  sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed,
+                   sycl::memory_scope::device>
+      ref(flags[i]);
+  ref.fetch_or(flag);
+}
+
+// Fall-through successor of entry i, or tasks if it has none.
+static uint64_t fall_through(const ControlFlowView &cfg, uint64_t tasks,
+                             uint64_t i) {
+  for (uint64_t e = cfg.offsets[i]; e < cfg.offsets[i + 1]; ++e)
+    if (cfg.kinds[e] == EdgeKind::FallThrough)
+      return cfg.columns[e];
+  return tasks;
+}
+
+ProgramPartition partition_program(sycl::queue &q, const SupersetView &view,
+                                   const ControlFlowGraph &cfg,
+                                   const uint8_t *mask) {
+  ProgramPartition res;
+  uint64_t tasks = view.tasks;
+  res.block_of.assign(tasks, ProgramPartition::NoBlock);
+  if (tasks == 0)
+    return res;
+  DeviceControlFlowGraph device_cfg(q, cfg);
+  ControlFlowView edges = device_cfg.view();
+
+  // Leaders.
+  uint32_t *flags = sycl::malloc_device<uint32_t>(tasks, q);
+  q.memset(flags, 0, tasks * sizeof(uint32_t)).wait();
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     bool conditional = view.attributes[i] & InstAttr::ConditionalBranch;
+     for (uint64_t e = edges.offsets[i]; e < edges.offsets[i + 1]; ++e) {
+       uint64_t dst = edges.columns[e];
+       switch (edges.kinds[e]) {
+       case EdgeKind::FallThrough:
+         set_flag(flags, dst, conditional ? FallenInto | Leader : FallenInto);
+         break;
+       case EdgeKind::Call:
+         set_flag(flags, dst, CallDestination | Leader);
+         break;
+       default:
+         set_flag(flags, dst, Leader);
+         break;
+       }
+     }
+   }).wait();
+  uint8_t *leaders = sycl::malloc_device<uint8_t>(tasks, q);
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     leaders[i] = view.valid(i) && (!mask || mask[i]) &&
+                  (flags[i] & (Leader | FallenInto)) != FallenInto;
+   }).wait();
+  uint64_t num_blocks;
+  uint64_t *firsts = compact_indices(q, leaders, tasks, num_blocks);
+
+  // Block extents, one work-item per block walking its fall-through chain.
+  BasicBlockInfo *blocks = sycl::malloc_device<BasicBlockInfo>(num_blocks, q);
+  uint64_t *block_of = sycl::malloc_device<uint64_t>(tasks, q);
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     block_of[i] = ProgramPartition::NoBlock;
+   }).wait();
+  q.parallel_for(num_blocks, [=](sycl::id<1> b) {
+     uint64_t i = firsts[b];
+     uint32_t count = 1;
+     block_of[i] = b;
+     for (uint64_t j = fall_through(edges, tasks, i);
+          j < tasks && !leaders[j]; j = fall_through(edges, tasks, i)) {
+       i = j;
+       block_of[i] = b;
+       ++count;
+     }
+     blocks[b] = {view.address(firsts[b]), view.address(i) + view.sizes[i],
+                  firsts[b], i, count, 0};
+   }).wait();
+
+  // Functions, as components of the intra-procedural edges leaving the last
+  // instruction of every block.
+  uint64_t *parent = sycl::malloc_device<uint64_t>(num_blocks, q);
+  q.parallel_for(num_blocks, [=](sycl::id<1> b) { parent[b] = b; }).wait();
+  q.parallel_for(num_blocks, [=](sycl::id<1> b) {
+     uint64_t i = blocks[b].last;
+     for (uint64_t e = edges.offsets[i]; e < edges.offsets[i + 1]; ++e) {
+       uint64_t dst = edges.columns[e];
+       if (edges.kinds[e] == EdgeKind::Call ||
+           (edges.kinds[e] == EdgeKind::Branch &&
+            (flags[dst] & CallDestination)))
+         continue;
+       if (block_of[dst] != ProgramPartition::NoBlock)
+         union_find_unite(parent, b, block_of[dst]);
+     }
+   }).wait();
+  uint8_t *roots = sycl::malloc_device<uint8_t>(num_blocks, q);
+  q.parallel_for(num_blocks, [=](sycl::id<1> b) {
+     parent[b] = union_find_root(parent, b);
+     roots[b] = parent[b] == b;
+   }).wait();
+  uint64_t num_functions;
+  uint64_t *function_roots =
+      compact_indices(q, roots, num_blocks, num_functions);
+  // Roots are the lowest block of their function, so function ids follow
+  // block order.
+  uint64_t *function_id = sycl::malloc_device<uint64_t>(num_blocks, q);
+  uint64_t *entries = sycl::malloc_device<uint64_t>(num_functions, q);
+  uint64_t *counts = sycl::malloc_device<uint64_t>(num_functions, q);
+  q.parallel_for(num_functions, [=](sycl::id<1> f) {
+     function_id[function_roots[f]] = f;
+     entries[f] = num_blocks;
+     counts[f] = 0;
+   }).wait();
+  q.parallel_for(num_blocks, [=](sycl::id<1> b) {
+     uint64_t f = function_id[parent[b]];
+     blocks[b].function = f;
+     sycl::atomic_ref<uint64_t, sycl::memory_order::relaxed,
+                      sycl::memory_scope::device>
+         count(counts[f]);
+     count.fetch_add(1);
+     if (flags[firsts[b]] & CallDestination) {
+       sycl::atomic_ref<uint64_t, sycl::memory_order::relaxed,
+                        sycl::memory_scope::device>
+           entry(entries[f]);
+       entry.fetch_min(b);
+     }
+   }).wait();
+
+  res.blocks.resize(num_blocks);
+  std::vector<uint64_t> entry_blocks(num_functions);
+  std::vector<uint64_t> roots_host(num_functions);
+  std::vector<uint64_t> counts_host(num_functions);
+  q.memcpy(res.blocks.data(), blocks, num_blocks * sizeof(BasicBlockInfo));
+  q.memcpy(res.block_of.data(), block_of, tasks * sizeof(uint64_t));
+  q.memcpy(entry_blocks.data(), entries, num_functions * sizeof(uint64_t));
+  q.memcpy(roots_host.data(), function_roots,
+           num_functions * sizeof(uint64_t));
+  q.memcpy(counts_host.data(), counts, num_functions * sizeof(uint64_t));
+  q.wait();
+  sycl::free(counts, q);
+  sycl::free(entries, q);
+  sycl::free(function_id, q);
+  sycl::free(function_roots, q);
+  sycl::free(roots, q);
+  sycl::free(parent, q);
+  sycl::free(block_of, q);
+  sycl::free(blocks, q);
+  sycl::free(firsts, q);
+  sycl::free(leaders, q);
+  sycl::free(flags, q);
+
+  // Group block indices by function, keeping address order.
+  res.functions.resize(num_functions);
+  uint64_t first_block = 0;
+  for (uint64_t f = 0; f < num_functions; ++f) {
+    uint64_t entry_block =
+        entry_blocks[f] < num_blocks ? entry_blocks[f] : roots_host[f];
+    res.functions[f] = {res.blocks[entry_block].start, first_block,
+                        counts_host[f]};
+    first_block += counts_host[f];
+  }
+  std::vector<uint64_t> fill(num_functions);
+  res.function_blocks.resize(num_blocks);
+  for (uint64_t b = 0; b < num_blocks; ++b) {
+    auto &function = res.functions[res.blocks[b].function];
+    res.function_blocks[function.first_block +
+                        fill[res.blocks[b].function]++] = b;
+  }
+  return res;
+}
+
+ProgramPartition partition_program(sycl::queue &q,
+                                   const InstInfoContainer &insts,
+                                   const ControlFlowGraph &cfg,
+                                   const std::vector<uint8_t> &mask) {
+  DeviceSuperset superset(q, insts);
+  uint8_t *mask_device = nullptr;
+  if (!mask.empty()) {
+    mask_device = sycl::malloc_device<uint8_t>(mask.size(), q);
+    q.memcpy(mask_device, mask.data(), mask.size()).wait();
+  }
+  auto res = partition_program(q, superset.view(), cfg, mask_device);
+  if (mask_device)
+    sycl::free(mask_device, q);
+  return res;
+}
+} // namespace gapstone
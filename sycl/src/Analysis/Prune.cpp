@@ -0,0 +1,79 @@
+#include "Analysis/Prune.h"
+#include "Analysis/Superset.h"
+#include <utility>
+
+namespace gapstone {
+namespace {
+enum ChainState : uint8_t { Unknown = 0, Good = 1, Bad = 2 };
+} // namespace
+
+void prune_invalid_chains(sycl::queue &q, const SupersetView &view,
+                          uint8_t *keep) {
+  uint64_t tasks = view.tasks;
+  if (tasks == 0)
+    return;
+  uint64_t *jump = sycl::malloc_device<uint64_t>(tasks, q);
+  uint64_t *jump_next = sycl::malloc_device<uint64_t>(tasks, q);
+  uint8_t *state = sycl::malloc_device<uint8_t>(tasks, q);
+  uint8_t *state_next = sycl::malloc_device<uint8_t>(tasks, q);
+  uint64_t *unresolved = sycl::malloc_shared<uint64_t>(1, q);
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     jump[i] = tasks;
+     if (!view.valid(i)) {
+       state[i] = Bad;
+       return;
+     }
+     uint64_t target = view.branch_target(i);
+     if (target < tasks && !view.valid(target)) {
+       state[i] = Bad;
+     } else if (view.ends_flow(i)) {
+       state[i] = Good;
+     } else {
+       jump[i] = view.next(i);
+       state[i] = jump[i] < tasks ? Unknown : Bad;
+     }
+   }).wait();
+  // Successors always lie at higher offsets, so every chain ends in a
+  // resolved entry and each round halves the distance to it.
+  do {
+    *unresolved = 0;
+    q.parallel_for(tasks, [=](sycl::id<1> i) {
+       state_next[i] = state[i];
+       jump_next[i] = jump[i];
+       if (state[i] != Unknown)
+         return;
+       uint64_t j = jump[i];
+       if (state[j] != Unknown) {
+         state_next[i] = state[j];
+         return;
+       }
+       jump_next[i] = jump[j];
+       sycl::atomic_ref<uint64_t, sycl::memory_order::relaxed,
+                        sycl::memory_scope::device>
+           count(*unresolved);
+       count.fetch_add(1);
+     }).wait();
+    std::swap(state, state_next);
+    std::swap(jump, jump_next);
+  } while (*unresolved);
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     keep[i] = state[i] == Good;
+   }).wait();
+  sycl::free(unresolved, q);
+  sycl::free(state_next, q);
+  sycl::free(state, q);
+  sycl::free(jump_next, q);
+  sycl::free(jump, q);
+}
+
+std::vector<uint8_t> prune_invalid_chains(sycl::queue &q,
+                                          const InstInfoContainer &insts) {
+  DeviceSuperset superset(q, insts);
+  uint8_t *keep = sycl::malloc_device<uint8_t>(superset.tasks(), q);
+  prune_invalid_chains(q, superset.view(), keep);
+  std::vector<uint8_t> res(superset.tasks());
+  q.memcpy(res.data(), keep, res.size()).wait();
+  sycl::free(keep, q);
+  return res;
+}
+} // namespace gapstone
@@ -0,0 +1,144 @@
+#include "Analysis/Sampling.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace gapstone {
+namespace {
+static bool decoded(const InstInfoContainer &insts, uint64_t k) {
+  return insts.status[k] != llvm::MCDisassembler::Fail;
+}
+
+static bool ends_flow(const InstInfoContainer &insts, uint64_t k) {
+  return insts.attributes[k] & (InstAttr::Barrier | InstAttr::Return);
+}
+} // namespace
+
+Proportion wilson_interval(uint64_t hits, uint64_t trials, double z) {
+  Proportion res;
+  res.trials = trials;
+  if (trials == 0)
+    return res;
+  double n = double(trials);
+  double p = double(hits) / n;
+  double z2 = z * z;
+  double center = (p + z2 / (2 * n)) / (1 + z2 / n);
+  double half =
+      z * std::sqrt(p * (1 - p) / n + z2 / (4 * n * n)) / (1 + z2 / n);
+  res.estimate = p;
+  res.low = std::max(0.0, center - half);
+  res.high = std::min(1.0, center + half);
+  return res;
+}
+
+std::vector<uint64_t> sample_offsets(uint64_t size, int step_size, double rate,
+                                     SampleMode mode, uint64_t seed) {
+  uint64_t slots = size / step_size;
+  if (slots == 0)
+    return {};
+  uint64_t count = uint64_t(std::ceil(rate * double(slots)));
+  count = std::clamp<uint64_t>(count, 1, slots);
+  std::mt19937_64 generator(seed);
+  std::vector<uint64_t> res;
+  res.reserve(count);
+  if (mode == SampleMode::Stratified) {
+    // The first slots % count strata hold one slot more.
+    uint64_t width = slots / count, wider = slots % count;
+    for (uint64_t j = 0; j < count; ++j) {
+      uint64_t low = j * width + std::min(j, wider);
+      uint64_t high = low + width + (j < wider);
+      std::uniform_int_distribution<uint64_t> pick(low, high - 1);
+      res.push_back(pick(generator) * step_size);
+    }
+    return res;
+  }
+  // Floyd's algorithm: count distinct slots in count draws.
+  std::unordered_set<uint64_t> chosen;
+  for (uint64_t j = slots - count; j < slots; ++j) {
+    std::uniform_int_distribution<uint64_t> pick(0, j);
+    uint64_t slot = pick(generator);
+    chosen.insert(chosen.count(slot) ? j : slot);
+  }
+  for (uint64_t slot : chosen)
+    res.push_back(slot * step_size);
+  std::sort(res.begin(), res.end());
+  return res;
+}
+
+SampleEstimate estimate_from_sample(SyclDisassembler &disassembler,
+                                    uint64_t base_addr,
+                                    std::vector<uint8_t> &content,
+                                    const std::vector<uint64_t> &offsets,
+                                    unsigned chain, unsigned top) {
+  SampleEstimate res;
+  res.samples = offsets.size();
+  if (offsets.empty())
+    return res;
+  auto insts =
+      disassembler.batch_disassemble_offsets(base_addr, content, offsets);
+
+  uint64_t valid = 0, code = 0, branches = 0;
+  std::unordered_map<uint16_t, uint64_t> opcode_counts;
+  std::vector<uint64_t> branch_targets;
+  // Offsets of the next instruction of every chain still running.
+  std::vector<uint64_t> pending;
+  for (uint64_t k = 0; k < offsets.size(); ++k) {
+    if (!decoded(*insts, k))
+      continue;
+    ++valid;
+    ++opcode_counts[insts->opcodes[k]];
+    uint8_t kind = insts->target_kinds[k];
+    if (kind == TargetKind::Branch || kind == TargetKind::Call) {
+      ++branches;
+      uint64_t target = insts->targets[k];
+      // Targets outside the blob stay inconsistent.
+      if (target >= base_addr && target - base_addr < content.size())
+        branch_targets.push_back(target - base_addr);
+    }
+    if (chain <= 1 || ends_flow(*insts, k))
+      ++code;
+    else
+      pending.push_back(offsets[k] + insts->sizes[k]);
+  }
+  for (unsigned round = 1; round < chain && !pending.empty(); ++round) {
+    auto next = disassembler.batch_disassemble_offsets(base_addr, content,
+                                                       pending);
+    std::vector<uint64_t> running;
+    for (uint64_t k = 0; k < pending.size(); ++k) {
+      if (!decoded(*next, k))
+        continue;
+      if (round + 1 == chain || ends_flow(*next, k))
+        ++code;
+      else
+        running.push_back(pending[k] + next->sizes[k]);
+    }
+    pending = std::move(running);
+  }
+  uint64_t consistent = 0;
+  if (!branch_targets.empty()) {
+    auto targets = disassembler.batch_disassemble_offsets(base_addr, content,
+                                                          branch_targets);
+    for (uint64_t k = 0; k < branch_targets.size(); ++k)
+      consistent += decoded(*targets, k);
+  }
+
+  res.decodes = wilson_interval(valid, offsets.size());
+  res.code = wilson_interval(code, offsets.size());
+  res.branch_consistency = wilson_interval(consistent, branches);
+  std::vector<std::pair<uint64_t, uint16_t>> ranked;
+  for (auto [opcode, count] : opcode_counts)
+    ranked.push_back({count, opcode});
+  top = std::min<uint64_t>(top, ranked.size());
+  std::partial_sort(ranked.begin(), ranked.begin() + top, ranked.end(),
+                    [](const auto &a, const auto &b) {
+                      return a.first != b.first ? a.first > b.first
+                                                : a.second < b.second;
+                    });
+  for (unsigned k = 0; k < top; ++k)
+    res.opcode_mix.push_back(
+        {ranked[k].second, wilson_interval(ranked[k].first, valid)});
+  return res;
+}
+} // namespace gapstone
@@ -0,0 +1,36 @@
+#include "Analysis/Superset.h"
+
+namespace gapstone {
+template <typename T>
+static const T *upload(sycl::queue &q, const std::vector<T> &host) {
+  T *device = sycl::malloc_device<T>(host.size(), q);
+  q.memcpy(device, host.data(), host.size() * sizeof(T));
+  return device;
+}
+
+DeviceSuperset::DeviceSuperset(sycl::queue &qq, const InstInfoContainer &insts)
+    : q(qq) {
+  View.status = upload(q, insts.status);
+  View.sizes = upload(q, insts.sizes);
+  View.attributes = upload(q, insts.attributes);
+  View.targets = upload(q, insts.targets);
+  View.target_kinds = upload(q, insts.target_kinds);
+  View.opcodes = upload(q, insts.opcodes);
+  View.tasks = insts.status.size();
+  View.base_addr = insts.base_addr;
+  View.step_size = insts.step_size;
+  View.ranges = upload(q, insts.ranges);
+  View.num_ranges = insts.ranges.size();
+  q.wait();
+}
+
+DeviceSuperset::~DeviceSuperset() {
+  sycl::free(const_cast<llvm::MCDisassembler::DecodeStatus *>(View.status), q);
+  sycl::free(const_cast<uint8_t *>(View.sizes), q);
+  sycl::free(const_cast<uint16_t *>(View.attributes), q);
+  sycl::free(const_cast<uint64_t *>(View.targets), q);
+  sycl::free(const_cast<uint8_t *>(View.target_kinds), q);
+  sycl::free(const_cast<uint16_t *>(View.opcodes), q);
+  sycl::free(const_cast<DecodeRange *>(View.ranges), q);
+}
+} // namespace gapstone
@@ -0,0 +1,85 @@
+#include "Analysis/Traversal.h"
+#include "Analysis/Primitives.h"
+#include "Analysis/Superset.h"
+#include <utility>
+
+namespace gapstone {
+// Claims entry j for the next frontier if it has not been visited yet.
+static void visit(const SupersetView &view, uint32_t *visited,
+                  uint64_t *frontier, uint64_t *size, uint64_t j) {
+  if (j >= view.tasks || !view.valid(j))
+    return;
+  sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed,
+                   sycl::memory_scope::device>
+      flag(visited[j]);
+  if (flag.exchange(1))
+    return;
+  sycl::atomic_ref<uint64_t, sycl::memory_order::relaxed,
+                   sycl::memory_scope::device>
+      slot(*size);
+  frontier[slot.fetch_add(1)] = j;
+}
+
+void recursive_traversal(sycl::queue &q, const SupersetView &view,
+                         const uint64_t *seeds, uint64_t seed_count,
+                         uint8_t *reached) {
+  uint64_t tasks = view.tasks;
+  if (tasks == 0)
+    return;
+  // Every entry joins a frontier at most once, so tasks slots are enough.
+  uint32_t *visited = sycl::malloc_device<uint32_t>(tasks, q);
+  uint64_t *frontier = sycl::malloc_device<uint64_t>(tasks, q);
+  uint64_t *next_frontier = sycl::malloc_device<uint64_t>(tasks, q);
+  uint64_t *next_size = sycl::malloc_shared<uint64_t>(1, q);
+  q.memset(visited, 0, tasks * sizeof(uint32_t)).wait();
+  *next_size = 0;
+  q.parallel_for(seed_count, [=](sycl::id<1> i) {
+     visit(view, visited, next_frontier, next_size, seeds[i]);
+   }).wait();
+  uint64_t frontier_size = *next_size;
+  while (frontier_size) {
+    std::swap(frontier, next_frontier);
+    *next_size = 0;
+    q.parallel_for(frontier_size, [=](sycl::id<1> k) {
+       uint64_t i = frontier[k];
+       if (!view.ends_flow(i))
+         visit(view, visited, next_frontier, next_size, view.next(i));
+       visit(view, visited, next_frontier, next_size, view.branch_target(i));
+     }).wait();
+    frontier_size = *next_size;
+  }
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     reached[i] = visited[i] != 0;
+   }).wait();
+  sycl::free(next_size, q);
+  sycl::free(next_frontier, q);
+  sycl::free(frontier, q);
+  sycl::free(visited, q);
+}
+
+std::vector<uint64_t>
+recursive_traversal(sycl::queue &q, const InstInfoContainer &insts,
+                    const std::vector<uint64_t> &entry_addresses) {
+  DeviceSuperset superset(q, insts);
+  const SupersetView &view = superset.view();
+  std::vector<uint64_t> seeds;
+  for (auto address : entry_addresses) {
+    uint64_t i = view.index_of(address);
+    if (i < view.tasks)
+      seeds.push_back(i);
+  }
+  uint64_t *seeds_device = sycl::malloc_device<uint64_t>(seeds.size(), q);
+  q.memcpy(seeds_device, seeds.data(), seeds.size() * sizeof(uint64_t))
+      .wait();
+  uint8_t *reached = sycl::malloc_device<uint8_t>(view.tasks, q);
+  recursive_traversal(q, view, seeds_device, seeds.size(), reached);
+  uint64_t count;
+  uint64_t *indices = compact_indices(q, reached, view.tasks, count);
+  std::vector<uint64_t> res(count);
+  q.memcpy(res.data(), indices, count * sizeof(uint64_t)).wait();
+  sycl::free(indices, q);
+  sycl::free(reached, q);
+  sycl::free(seeds_device, q);
+  return res;
+}
+} // namespace gapstone
@@ -0,0 +1,64 @@
+#include "Analysis/Xref.h"
+#include "Analysis/Primitives.h"
+#include "Analysis/Superset.h"
+
+namespace gapstone {
+XrefIndex build_xref_index(sycl::queue &q, const SupersetView &view,
+                           const uint8_t *mask, uint64_t imm_low,
+                           uint64_t imm_high) {
+  uint64_t tasks = view.tasks;
+  uint8_t *flags = sycl::malloc_device<uint8_t>(tasks, q);
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     uint8_t kind = view.target_kinds[i];
+     flags[i] = view.valid(i) && (!mask || mask[i]) &&
+                kind != TargetKind::None &&
+                (kind != TargetKind::Immediate ||
+                 (view.targets[i] >= imm_low && view.targets[i] < imm_high));
+   }).wait();
+  uint64_t count;
+  uint64_t *referrers = compact_indices(q, flags, tasks, count);
+  uint64_t *keys = sycl::malloc_device<uint64_t>(count, q);
+  q.parallel_for(count, [=](sycl::id<1> k) {
+     keys[k] = view.targets[referrers[k]];
+   }).wait();
+  // Referrers come out of the compaction in address order and the sort is
+  // stable, so the references to one target stay in address order.
+  radix_sort_pairs(q, keys, referrers, count);
+  uint64_t *sources = sycl::malloc_device<uint64_t>(count, q);
+  uint8_t *kinds = sycl::malloc_device<uint8_t>(count, q);
+  q.parallel_for(count, [=](sycl::id<1> k) {
+     sources[k] = view.address(referrers[k]);
+     kinds[k] = view.target_kinds[referrers[k]];
+   }).wait();
+  XrefIndex res;
+  res.targets.resize(count);
+  res.sources.resize(count);
+  res.kinds.resize(count);
+  q.memcpy(res.targets.data(), keys, count * sizeof(uint64_t));
+  q.memcpy(res.sources.data(), sources, count * sizeof(uint64_t));
+  q.memcpy(res.kinds.data(), kinds, count * sizeof(uint8_t));
+  q.wait();
+  sycl::free(kinds, q);
+  sycl::free(sources, q);
+  sycl::free(keys, q);
+  sycl::free(referrers, q);
+  sycl::free(flags, q);
+  return res;
+}
+
+XrefIndex build_xref_index(sycl::queue &q, const InstInfoContainer &insts,
+                           const std::vector<uint8_t> &mask, uint64_t imm_low,
+                           uint64_t imm_high) {
+  DeviceSuperset superset(q, insts);
+  uint8_t *mask_device = nullptr;
+  if (!mask.empty()) {
+    mask_device = sycl::malloc_device<uint8_t>(mask.size(), q);
+    q.memcpy(mask_device, mask.data(), mask.size()).wait();
+  }
+  auto res =
+      build_xref_index(q, superset.view(), mask_device, imm_low, imm_high);
+  if (mask_device)
+    sycl::free(mask_device, q);
+  return res;
+}
+} // namespace gapstone
@@ -1,11 +1,17 @@
 #include "AArch64/AArch64SyclDisassembler.h"
 #include "AArch64/Decode.h"
+#include "Analysis/AddressPairs.h"
+#include "Analysis/FunctionStarts.h"
+#include "Analysis/JumpTables.h"
+#include "Analysis/Primitives.h"
+#include "Analysis/Superset.h"
 #include "DecodeInstruction.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/MC/MCDisassembler/MCDisassembler.h"
 #include <range.hpp>
 #include <sycl/sycl.hpp>
 #include <usm.hpp>
+#include <unordered_map>
 #include <vector>
 namespace gapstone {
 
@@ -36,7 +42,195 @@ static DecodeStatus disassemble_instruction(MCInstGPU_AArch64 &MI,
   return MCDisassembler::Fail;
 }
 
+static uint8_t get_target(const MCInstGPU_AArch64 &MI, uint64_t Address,
+                          uint64_t &Target) {
+  switch (MI.getOpcode()) {
+  case AArch64::ADR:
+    Target = Address + MI.getOperand(1).getImm();
+    return gapstone::TargetKind::Memory;
+  case AArch64::ADRP:
+    Target = (Address & ~0xfffULL) + (MI.getOperand(1).getImm() * 4096);
+    return gapstone::TargetKind::Page;
+  default:
+    break;
+  }
+  const MCInstrDesc &Desc = getMCID(MI.getOpcode());
+  int Idx = gapstone::getTargetOperand(Desc, MI);
+  if (Idx < 0)
+    return gapstone::TargetKind::None;
+  // Branch and literal offsets are encoded in words.
+  Target = Address + MI.getOperand(Idx).getImm() * 4;
+  if (Desc.isCall())
+    return gapstone::TargetKind::Call;
+  if (Desc.isBranch())
+    return gapstone::TargetKind::Branch;
+  return gapstone::TargetKind::Memory;
+}
+
 #include "DisassembleImpl.h"
+
+// FunctionHint bits of a single entry marker instruction.
+static uint32_t get_marker_hints(uint32_t Word) {
+  // bti c, bti jc
+  if (Word == 0xd503245f || Word == 0xd50324df)
+    return FunctionHint::LandingPad;
+  // paciasp, pacibsp
+  if (Word == 0xd503233f || Word == 0xd503237f)
+    return FunctionHint::PointerAuth;
+  // stp x29, x30, [sp, #-N]!
+  if ((Word & 0xffc07fff) == 0xa9807bfd && (Word & 0x00200000))
+    return FunctionHint::FramePrologue;
+  return FunctionHint::None;
+}
+
+static uint32_t read_word(const uint8_t *Bytes, uint64_t Offset) {
+  return Bytes[Offset] | (Bytes[Offset + 1] << 8) | (Bytes[Offset + 2] << 16) |
+         ((uint32_t)Bytes[Offset + 3] << 24);
+}
+
+// FunctionHint bits of superset entry I. A prologue such as
+// bti c; paciasp; stp x29, x30, [sp, #-N]! is reported once, at its first
+// marker, so every function yields a single entry.
+static uint32_t get_function_hints(const SupersetView &View,
+                                   const uint8_t *Bytes, uint64_t Size,
+                                   uint64_t I) {
+  uint64_t Offset = I * View.step_size;
+  if (!View.valid(I) || Offset % 4 || Offset + 4 > Size)
+    return FunctionHint::None;
+  if (Offset >= 4 && !View.starts_range(I) &&
+      (get_marker_hints(read_word(Bytes, Offset - 4)) &
+       (FunctionHint::LandingPad | FunctionHint::PointerAuth)))
+    return FunctionHint::None;
+  uint32_t Hints = get_marker_hints(read_word(Bytes, Offset));
+  // The frame record store ends the prologue.
+  for (Offset += 4; Hints && !(Hints & FunctionHint::FramePrologue) &&
+                    Offset + 4 <= Size;
+       Offset += 4) {
+    uint32_t Marker = get_marker_hints(read_word(Bytes, Offset));
+    if (!Marker || (Hints & Marker))
+      break;
+    Hints |= Marker;
+  }
+  return Hints;
+}
+
+// Completes the address in register Reg, holding Page, if Word is an
+// add (immediate) or a load/store (unsigned offset) based on Reg.
+static uint8_t get_page_use(uint32_t Word, uint32_t Reg, uint64_t Page,
+                            uint64_t &Address) {
+  if (((Word >> 5) & 0x1f) != Reg)
+    return TargetKind::None;
+  uint64_t Imm = (Word >> 10) & 0xfff;
+  // add xd, xn, #imm{, lsl #12}
+  if ((Word & 0xff800000) == 0x91000000) {
+    Address = Page + (Imm << ((Word & 0x00400000) ? 12 : 0));
+    return TargetKind::Immediate;
+  }
+  // ldr/str xt, [xn, #imm], offset scaled by the access size
+  if ((Word & 0x3b000000) == 0x39000000) {
+    unsigned Scale = Word >> 30;
+    if ((Word & 0x04000000) && (Word & 0x00800000))
+      Scale = 4;
+    Address = Page + (Imm << Scale);
+    return TargetKind::Memory;
+  }
+  return TargetKind::None;
+}
+
+// Encoding of a general-purpose register, its index in the W or X register
+// classes, or -1 for any other register.
+static int get_gpr_number(unsigned Reg) {
+  for (unsigned ClassID :
+       {AArch64::GPR64spRegClassID, AArch64::GPR64RegClassID,
+        AArch64::GPR32spRegClassID, AArch64::GPR32RegClassID}) {
+    const MCRegisterClass &Class = AArch64MCRegisterClasses[ClassID];
+    for (unsigned N = 0; N < Class.getNumRegs(); ++N)
+      if (Class.getRegister(N) == Reg)
+        return N;
+  }
+  return -1;
+}
+
+// Bit N is set when MI writes general-purpose register N, through any def
+// operand of its MCInstrDesc. Writes to Wn clobber Xn as well.
+template <typename InstT> static uint32_t get_gpr_defs(const InstT &MI) {
+  const MCInstrDesc &Desc = getMCID(MI.getOpcode());
+  uint32_t Defs = 0;
+  for (unsigned Op = 0; Op < Desc.getNumDefs() && Op < MI.getNumOperands();
+       ++Op) {
+    if (!MI.getOperand(Op).isReg())
+      continue;
+    int N = get_gpr_number(MI.getOperand(Op).getReg());
+    if (N >= 0)
+      Defs |= 1u << N;
+  }
+  return Defs;
+}
+
+// Device array of the def masks of every entry of Insts, computed in a
+// kernel from the decoded operands. A decode made on the host is masked
+// there, its instructions having no device form.
+static uint32_t *get_gpr_defs(sycl::queue &q, const SupersetView &View,
+                              InstInfoContainer &Insts) {
+  uint64_t Tasks = View.tasks;
+  uint32_t *Defs = sycl::malloc_device<uint32_t>(Tasks, q);
+  auto *GPU = dynamic_cast<InstInfoContainerGPU<MCInstGPU_AArch64> *>(&Insts);
+  if (!GPU) {
+    auto &CPU = dynamic_cast<InstInfoContainerCPU &>(Insts);
+    std::vector<uint32_t> HostDefs(Tasks);
+    for (uint64_t I = 0; I < Tasks; ++I)
+      if (CPU.status[I] != MCDisassembler::Fail)
+        HostDefs[I] = get_gpr_defs(CPU.insts[I]);
+    q.memcpy(Defs, HostDefs.data(), Tasks * sizeof(uint32_t)).wait();
+    return Defs;
+  }
+  MCInstGPU_AArch64 *DeviceInsts =
+      sycl::malloc_device<MCInstGPU_AArch64>(Tasks, q);
+  q.memcpy(DeviceInsts, GPU->insts.data(), Tasks * sizeof(MCInstGPU_AArch64))
+      .wait();
+  q.parallel_for(Tasks, [=](sycl::id<1> I) {
+     Defs[I] = View.valid(I) ? get_gpr_defs(DeviceInsts[I]) : 0;
+   }).wait();
+  sycl::free(DeviceInsts, q);
+  return Defs;
+}
+
+// Calls F(Consumer, Address, Kind) for every use of the page formed by the
+// adrp at entry I, scanning Window instructions of straight-line code until
+// the register is redefined or the flow leaves.
+template <typename F>
+static void for_each_page_use(const SupersetView &View, const uint8_t *Bytes,
+                              const uint32_t *Defs, uint64_t I,
+                              unsigned Window, F &&Fn) {
+  if (!View.valid(I) || View.target_kinds[I] != TargetKind::Page)
+    return;
+  uint64_t Page = View.targets[I];
+  uint32_t Reg = read_word(Bytes, I * View.step_size) & 0x1f;
+  uint64_t J = I;
+  for (unsigned K = 0; K < Window; ++K) {
+    J = View.next(J);
+    if (J == View.tasks || !View.valid(J))
+      return;
+    uint32_t Word = read_word(Bytes, J * View.step_size);
+    uint64_t Address;
+    uint8_t Kind = get_page_use(Word, Reg, Page, Address);
+    if (Kind != TargetKind::None)
+      Fn(J, Address, Kind);
+    if (((Defs[J] >> Reg) & 1) || View.ends_flow(J) ||
+        (View.attributes[J] & (InstAttr::Branch | InstAttr::Call)))
+      return;
+  }
+}
+
+// Entry size of a table load ldr{b,h,sb,sh,sw} wt, [xn, wm, uxtw {#s}],
+// 0 for any other instruction.
+static unsigned get_table_load_size(uint32_t Word) {
+  if ((Word & 0x3f200c00) != 0x38200800 || !(Word & 0x00c00000))
+    return 0;
+  return 1u << (Word >> 30);
+}
+
+static bool is_adr(uint32_t Word) { return (Word & 0x9f000000) == 0x10000000; }
 } // namespace AArch64Impl
 
 std::unique_ptr<InstInfoContainer> AArch64Disassembler::batch_disassemble(
@@ -44,4 +238,137 @@ std::unique_ptr<InstInfoContainer> AArch64Disassembler::batch_disassemble(
   return AArch64Impl::disassemble_impl<MCInstGPU_AArch64>(
       q, MCDisassembler, base_addr, content, step_size);
 }
+
+std::unique_ptr<InstInfoContainer>
+AArch64Disassembler::batch_disassemble_ranges(
+    std::vector<uint8_t> &content, const std::vector<DecodeRange> &ranges,
+    int step_size, const std::vector<uint64_t> *offsets) {
+  return AArch64Impl::disassemble_ranges_impl<MCInstGPU_AArch64>(
+      q, MCDisassembler, content, ranges, step_size, offsets);
+}
+
+std::unique_ptr<InstInfoContainer>
+AArch64Disassembler::batch_disassemble_selected(
+    uint64_t base_addr, std::vector<uint8_t> &content, int step_size,
+    const std::vector<uint64_t> &offsets) {
+  return AArch64Impl::disassemble_selected_impl<MCInstGPU_AArch64>(
+      q, MCDisassembler, base_addr, content, step_size, offsets);
+}
+
+std::unique_ptr<InstInfoContainer>
+AArch64Disassembler::batch_disassemble_offsets(
+    uint64_t base_addr, std::vector<uint8_t> &content,
+    const std::vector<uint64_t> &offsets) {
+  return AArch64Impl::disassemble_offsets_impl<MCInstGPU_AArch64>(
+      q, MCDisassembler, base_addr, content, offsets);
+}
+
+std::vector<FunctionCandidate>
+AArch64Disassembler::function_starts(InstInfoContainer &insts,
+                                     std::vector<uint8_t> &content) {
+  DeviceSuperset superset(q, insts);
+  SupersetView view = superset.view();
+  uint64_t size = content.size();
+  uint8_t *bytes = sycl::malloc_device<uint8_t>(size, q);
+  uint32_t *hints = sycl::malloc_device<uint32_t>(view.tasks, q);
+  q.memcpy(bytes, content.data(), size).wait();
+  q.parallel_for(view.tasks, [=](sycl::id<1> i) {
+     hints[i] = AArch64Impl::get_function_hints(view, bytes, size, i);
+   }).wait();
+  mark_call_targets(q, view, hints).wait();
+  // Every marker and bl target is sufficient evidence on its own.
+  auto res = collect_function_candidates(q, view, hints);
+  sycl::free(hints, q);
+  sycl::free(bytes, q);
+  return res;
+}
+
+std::vector<ResolvedAddress>
+AArch64Disassembler::resolve_address_pairs(InstInfoContainer &insts,
+                                           std::vector<uint8_t> &content,
+                                           unsigned window) {
+  DeviceSuperset superset(q, insts);
+  SupersetView view = superset.view();
+  uint64_t size = content.size();
+  uint64_t tasks = view.tasks;
+  uint32_t *defs = AArch64Impl::get_gpr_defs(q, view, insts);
+  uint8_t *bytes = sycl::malloc_device<uint8_t>(size, q);
+  uint64_t *offsets = sycl::malloc_device<uint64_t>(tasks, q);
+  q.memcpy(bytes, content.data(), size).wait();
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     uint64_t count = 0;
+     AArch64Impl::for_each_page_use(view, bytes, defs, i, window,
+                                    [&](uint64_t, uint64_t, uint8_t) {
+                                      ++count;
+                                    });
+     offsets[i] = count;
+   }).wait();
+  uint64_t total = exclusive_scan(q, offsets, offsets, tasks);
+  ResolvedAddress *pairs = sycl::malloc_device<ResolvedAddress>(total, q);
+  q.parallel_for(tasks, [=](sycl::id<1> i) {
+     uint64_t k = offsets[i];
+     AArch64Impl::for_each_page_use(
+         view, bytes, defs, i, window,
+         [&](uint64_t consumer, uint64_t address, uint8_t kind) {
+           pairs[k++] = {view.address(i), view.address(consumer), address,
+                         kind};
+         });
+   }).wait();
+  std::vector<ResolvedAddress> res(total);
+  q.memcpy(res.data(), pairs, total * sizeof(ResolvedAddress)).wait();
+  sycl::free(pairs, q);
+  sycl::free(offsets, q);
+  sycl::free(defs, q);
+  sycl::free(bytes, q);
+  return res;
+}
+
+std::vector<JumpTable>
+AArch64Disassembler::find_jump_tables(InstInfoContainer &insts,
+                                      std::vector<uint8_t> &content,
+                                      const std::vector<uint8_t> &mask) {
+  // adrp + add pairs forming a table address, keyed by the add.
+  std::unordered_map<uint64_t, uint64_t> formed;
+  for (const ResolvedAddress &pair : resolve_address_pairs(insts, content))
+    if (pair.kind == TargetKind::Immediate)
+      formed[pair.consumer] = pair.address;
+
+  // The sequence compilers emit for a switch is
+  //   adrp xt, table; add xt, xt, :lo12:table
+  //   ldrb wd, [xt, wi, uxtw]
+  //   adr xb, base
+  //   add xb, xb, wd, sxtb #2
+  //   br xb
+  // with the adr missing when entries are relative to the table itself.
+  SupersetView view = host_view(insts);
+  std::vector<JumpTable> res;
+  for (uint64_t i : collect_indirect_jumps(q, insts, mask)) {
+    unsigned entry_size = 0;
+    bool has_base = false;
+    uint64_t base = 0;
+    for (uint64_t j : preceding_instructions(view, mask, i, 8)) {
+      uint64_t offset = j * view.step_size;
+      if (offset % 4 || offset + 4 > content.size())
+        break;
+      uint32_t word = AArch64Impl::read_word(content.data(), offset);
+      if (!entry_size) {
+        entry_size = AArch64Impl::get_table_load_size(word);
+        if (!entry_size && AArch64Impl::is_adr(word)) {
+          has_base = true;
+          base = view.targets[j];
+        }
+        continue;
+      }
+      auto table = formed.find(view.address(j));
+      if (table == formed.end())
+        continue;
+      res.push_back({view.address(i), table->second,
+                     has_base ? base : table->second, uint8_t(entry_size),
+                     uint8_t(has_base ? 2 : 0), JumpTableEncoding::Relative,
+                     0});
+      break;
+    }
+  }
+  return res;
+}
 } // namespace gapstone
\ No newline at end of file
@@ -252,6 +252,27 @@ static DecodeStatus decode_instruction(MCInst &MI, ArrayRef<uint8_t> Bytes,
   return getARMInstruction(MI, MI.Size, Bytes, Address, Bits);
 }
 
+// PC-relative operands count from the PC, which reads 8 bytes ahead in ARM
+// state and 4 in Thumb state, where literal loads also align it down to a
+// word.
+static uint8_t get_target(const MCInstGPU_ARM &MI, uint64_t Address,
+                          const FeatureBitset &Bits, uint64_t &Target) {
+  const MCInstrDesc &Desc = getMCID(MI.getOpcode());
+  int Idx = gapstone::getTargetOperand(Desc, MI);
+  if (Idx < 0)
+    return gapstone::TargetKind::None;
+  bool Thumb = Bits[ARM::ModeThumb];
+  uint64_t PC = Thumb ? Address + 4 : Address + 8;
+  Target = PC + MI.getOperand(Idx).getImm();
+  if (Desc.isCall())
+    return gapstone::TargetKind::Call;
+  if (Desc.isBranch())
+    return gapstone::TargetKind::Branch;
+  if (Thumb)
+    Target = (PC & ~3ULL) + MI.getOperand(Idx).getImm();
+  return gapstone::TargetKind::Memory;
+}
+
 #include "DisassembleImpl.h"
 } // namespace ARMImpl
 
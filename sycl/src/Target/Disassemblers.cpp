@@ -1,5 +1,8 @@
 #include "Disassemblers.h"
 #include "AArch64/AArch64SyclDisassembler.h"
+#include "Analysis/AddressPairs.h"
+#include "Analysis/FunctionStarts.h"
+#include "Analysis/JumpTables.h"
 #include "Lanai/LanaiSyclDisassembler.h"
 #include "LoongArch/LoongArchSyclDisassembler.h"
 #include "X86/X86SyclDisassembler.h"
@@ -13,6 +16,26 @@
 #include <stdexcept>
 
 namespace gapstone {
+std::vector<FunctionCandidate>
+SyclDisassembler::function_starts(InstInfoContainer &insts,
+                                  std::vector<uint8_t> &content) {
+  throw std::invalid_argument("Not implemented yet");
+}
+
+std::vector<ResolvedAddress>
+SyclDisassembler::resolve_address_pairs(InstInfoContainer &insts,
+                                        std::vector<uint8_t> &content,
+                                        unsigned window) {
+  throw std::invalid_argument("Not implemented yet");
+}
+
+std::vector<JumpTable>
+SyclDisassembler::find_jump_tables(InstInfoContainer &insts,
+                                   std::vector<uint8_t> &content,
+                                   const std::vector<uint8_t> &mask) {
+  throw std::invalid_argument("Not implemented yet");
+}
+
 std::unique_ptr<SyclDisassembler> createDisassembler(llvm::MCDisassembler &dd,
                                                      sycl::queue &qq) {
   auto triple = dd.getSubtargetInfo().getTargetTriple();
@@ -0,0 +1,220 @@
+#include "Identify.h"
+#include "Analysis/Histogram.h"
+#include "Analysis/LinearSweep.h"
+#include "Analysis/Padding.h"
+#include "Disassemblers.h"
+#include "llvm/MC/MCAsmInfo.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCDisassembler/MCDisassembler.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/MC/MCTargetOptions.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/TargetParser/Triple.h"
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <optional>
+
+namespace gapstone {
+const std::vector<ArchCandidate> &arch_candidates() {
+  static const std::vector<ArchCandidate> Candidates = {
+      {"x86-16", "i386-unknown-unknown-code16", 1, 0},
+      {"x86-32", "i386-unknown-unknown", 1, 0},
+      {"x86-64", "x86_64-unknown-unknown", 1, 0},
+      {"aarch64", "aarch64-unknown-unknown", 4, 0},
+      {"aarch64 (swapped)", "aarch64-unknown-unknown", 4, 4},
+      {"loongarch64", "loongarch64-unknown-unknown", 4, 0},
+      {"loongarch64 (swapped)", "loongarch64-unknown-unknown", 4, 4},
+      {"lanai", "lanai-unknown-unknown", 4, 0},
+      {"lanai (swapped)", "lanai-unknown-unknown", 4, 4},
+      {"m68k", "m68k-unknown-unknown", 2, 0},
+      {"m68k (swapped)", "m68k-unknown-unknown", 2, 2},
+  };
+  return Candidates;
+}
+
+// Whether offset lies in a run of at least MinPaddingRun equal 0x00 or 0xCC
+// bytes, the fill scan_padding reports.
+static bool in_fill_run(const std::vector<uint8_t> &content, uint64_t offset) {
+  uint8_t byte = content[offset];
+  if (byte != 0x00 && byte != 0xCC)
+    return false;
+  uint64_t begin = offset, end = offset + 1;
+  while (begin > 0 && end - begin < MinPaddingRun &&
+         content[begin - 1] == byte)
+    --begin;
+  while (end < content.size() && end - begin < MinPaddingRun &&
+         content[end] == byte)
+    ++end;
+  return end - begin >= MinPaddingRun;
+}
+
+// The blob with the bytes of every width-byte word reversed, swapped on the
+// device from its uploaded copy. A trailing partial word is left as is.
+static std::vector<uint8_t> swap_words(sycl::queue &q, const uint8_t *blob,
+                                       uint64_t size, unsigned width) {
+  std::vector<uint8_t> res(size);
+  uint64_t whole = size - size % width;
+  uint8_t *swapped = sycl::malloc_device<uint8_t>(size, q);
+  q.parallel_for(size, [=](sycl::id<1> i) {
+     uint64_t word = i - i % width;
+     swapped[i] = i < whole ? blob[word + width - 1 - i % width] : blob[i];
+   }).wait();
+  q.memcpy(res.data(), swapped, size).wait();
+  sycl::free(swapped, q);
+  return res;
+}
+
+// Scores one candidate on content, the blob already in the byte order the
+// candidate asks for. Candidates sharing a byte order share content.
+static std::optional<ArchGuess> score_candidate(sycl::queue &q,
+                                                const ArchCandidate &candidate,
+                                                std::vector<uint8_t> &content,
+                                                uint64_t base_addr,
+                                                double sample_rate,
+                                                SampleMode mode) {
+  std::string error;
+  llvm::Triple triple(candidate.triple);
+  const llvm::Target *target =
+      llvm::TargetRegistry::lookupTarget(triple.getTriple(), error);
+  if (!target)
+    return std::nullopt;
+  std::unique_ptr<llvm::MCRegisterInfo> register_info(
+      target->createMCRegInfo(triple.getTriple()));
+  llvm::MCTargetOptions target_options;
+  std::unique_ptr<llvm::MCAsmInfo> assembler_info(target->createMCAsmInfo(
+      *register_info, triple.getTriple(), target_options));
+  std::unique_ptr<llvm::MCInstrInfo> instruction_info(
+      target->createMCInstrInfo());
+  std::unique_ptr<llvm::MCSubtargetInfo> subtarget_info(
+      target->createMCSubtargetInfo(triple.getTriple(), "", ""));
+  if (!register_info || !assembler_info || !instruction_info ||
+      !subtarget_info)
+    return std::nullopt;
+  llvm::MCContext context(triple, assembler_info.get(), register_info.get(),
+                          subtarget_info.get(), nullptr, &target_options);
+  std::unique_ptr<llvm::MCDisassembler> disassembler(
+      target->createMCDisassembler(*subtarget_info, context));
+  if (!disassembler)
+    return std::nullopt;
+  auto gapstone_disassembler = createDisassembler(*disassembler, q);
+
+  // Padding is left out of every measure: a blob of fill decodes as a long
+  // run of one instruction under most candidates, and would score highest.
+  ArchGuess res;
+  res.candidate = candidate;
+  if (sample_rate > 0) {
+    auto offsets = sample_offsets(content.size(), candidate.step_size,
+                                  sample_rate, mode);
+    offsets.erase(std::remove_if(offsets.begin(), offsets.end(),
+                                 [&](uint64_t offset) {
+                                   return in_fill_run(content, offset);
+                                 }),
+                  offsets.end());
+    auto estimate =
+        estimate_from_sample(*gapstone_disassembler, base_addr, content,
+                             offsets, 4, ArchGuess::TopOpcodes);
+    res.validity = estimate.code.estimate;
+    res.validity_low = estimate.code.low;
+    res.validity_high = estimate.code.high;
+    res.concentration = 0.0;
+    for (auto &share : estimate.opcode_mix)
+      res.concentration += share.share.estimate;
+    res.branch_consistency = estimate.branch_consistency.trials
+                                 ? estimate.branch_consistency.estimate
+                                 : 0.5;
+    res.score = res.validity * res.concentration * res.branch_consistency;
+    return res;
+  }
+  auto padding =
+      scan_padding(q, content, candidate.step_size,
+                   nop_patterns(triple.getArch()), MinPaddingRun);
+  auto insts = gapstone_disassembler->batch_disassemble_selected(
+      base_addr, content, candidate.step_size, padding.offsets);
+  std::vector<uint8_t> padded(insts->status.size());
+  uint64_t step = candidate.step_size;
+  for (const PaddingRun &run : padding.runs)
+    for (uint64_t i = (run.begin + step - 1) / step;
+         i < padded.size() && i * step < run.end; ++i)
+      padded[i] = 1;
+  auto indices = linear_sweep(q, *insts);
+  std::vector<uint8_t> mask(insts->status.size());
+  uint64_t swept = 0, valid = 0, branches = 0, consistent = 0;
+  for (auto i : indices) {
+    if (padded[i])
+      continue;
+    ++swept;
+    if (insts->status[i] == llvm::MCDisassembler::Fail)
+      continue;
+    mask[i] = 1;
+    ++valid;
+    if (insts->target_kinds[i] != TargetKind::Branch &&
+        insts->target_kinds[i] != TargetKind::Call)
+      continue;
+    ++branches;
+    uint64_t target_addr = insts->targets[i];
+    if (target_addr < base_addr ||
+        (target_addr - base_addr) % candidate.step_size)
+      continue;
+    uint64_t t = (target_addr - base_addr) / candidate.step_size;
+    consistent += t < insts->status.size() &&
+                  insts->status[t] != llvm::MCDisassembler::Fail;
+  }
+
+  res.validity = swept ? double(valid) / swept : 0.0;
+  res.validity_low = res.validity_high = res.validity;
+  auto histogram = section_histograms(q, *insts, mask, 1,
+                                      instruction_info->getNumOpcodes());
+  std::vector<uint32_t> counts = histogram.counts;
+  unsigned top = std::min<uint64_t>(ArchGuess::TopOpcodes, counts.size());
+  std::partial_sort(counts.begin(), counts.begin() + top, counts.end(),
+                    std::greater<uint32_t>());
+  uint64_t common = 0;
+  for (unsigned k = 0; k < top; ++k)
+    common += counts[k];
+  res.concentration = valid ? double(common) / valid : 0.0;
+  res.branch_consistency = branches ? double(consistent) / branches : 0.5;
+  res.score = res.validity * res.concentration * res.branch_consistency;
+  return res;
+}
+
+std::vector<ArchGuess>
+identify_architecture(sycl::queue &q, const std::vector<uint8_t> &blob,
+                      uint64_t base_addr, double sample_rate,
+                      SampleMode mode) {
+  // One copy of the blob per byte order rather than per candidate.
+  std::map<unsigned, std::vector<uint8_t>> orders;
+  orders[0] = blob;
+  if (!blob.empty()) {
+    uint8_t *device_blob = sycl::malloc_device<uint8_t>(blob.size(), q);
+    q.memcpy(device_blob, blob.data(), blob.size()).wait();
+    for (const ArchCandidate &candidate : arch_candidates())
+      if (candidate.swap && !orders.count(candidate.swap))
+        orders[candidate.swap] =
+            swap_words(q, device_blob, blob.size(), candidate.swap);
+    sycl::free(device_blob, q);
+  }
+  std::vector<std::future<std::optional<ArchGuess>>> pending;
+  for (const ArchCandidate &candidate : arch_candidates()) {
+    auto &content = orders.count(candidate.swap) ? orders[candidate.swap]
+                                                 : orders[0];
+    pending.push_back(std::async(std::launch::async, score_candidate,
+                                 std::ref(q), std::cref(candidate),
+                                 std::ref(content), base_addr, sample_rate,
+                                 mode));
+  }
+  std::vector<ArchGuess> res;
+  for (auto &guess : pending)
+    if (auto scored = guess.get())
+      res.push_back(*scored);
+  std::stable_sort(res.begin(), res.end(),
+                   [](const ArchGuess &a, const ArchGuess &b) {
+                     return a.score > b.score;
+                   });
+  return res;
+}
+} // namespace gapstone
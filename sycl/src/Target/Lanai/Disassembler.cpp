@@ -33,6 +33,23 @@ disassemble_instruction(MCInstGPU_Lanai &MI, ArrayRef<uint8_t> &Bytes,
 
   return MCDisassembler::Fail;
 }
+
+static uint8_t get_target(const MCInstGPU_Lanai &MI, uint64_t Address,
+                          uint64_t &Target) {
+  const MCInstrDesc &Desc = getMCID(MI.getOpcode());
+  // Lanai does not tag its branch operands; direct branches carry an absolute
+  // address first, followed by the condition code.
+  if (!(Desc.isCall() || Desc.isBranch()) || Desc.isReturn() ||
+      !gapstone::hasDirectTarget(Desc))
+    return gapstone::TargetKind::None;
+  int Idx = gapstone::getImmediateOperand(MI);
+  if (Idx < 0)
+    return gapstone::TargetKind::None;
+  Target = MI.getOperand(Idx).getImm();
+  return Desc.isCall() ? gapstone::TargetKind::Call
+                       : gapstone::TargetKind::Branch;
+}
+
 #include "DisassembleImpl.h"
 } // namespace LanaiImpl
 std::unique_ptr<InstInfoContainer> LanaiDisassembler::batch_disassemble(
@@ -40,4 +57,28 @@ std::unique_ptr<InstInfoContainer> LanaiDisassembler::batch_disassemble(
   return LanaiImpl::disassemble_impl<MCInstGPU_Lanai>(
       q, MCDisassembler, base_addr, content, step_size);
 }
+
+std::unique_ptr<InstInfoContainer>
+LanaiDisassembler::batch_disassemble_ranges(
+    std::vector<uint8_t> &content, const std::vector<DecodeRange> &ranges,
+    int step_size, const std::vector<uint64_t> *offsets) {
+  return LanaiImpl::disassemble_ranges_impl<MCInstGPU_Lanai>(
+      q, MCDisassembler, content, ranges, step_size, offsets);
+}
+
+std::unique_ptr<InstInfoContainer>
+LanaiDisassembler::batch_disassemble_selected(
+    uint64_t base_addr, std::vector<uint8_t> &content, int step_size,
+    const std::vector<uint64_t> &offsets) {
+  return LanaiImpl::disassemble_selected_impl<MCInstGPU_Lanai>(
+      q, MCDisassembler, base_addr, content, step_size, offsets);
+}
+
+std::unique_ptr<InstInfoContainer>
+LanaiDisassembler::batch_disassemble_offsets(
+    uint64_t base_addr, std::vector<uint8_t> &content,
+    const std::vector<uint64_t> &offsets) {
+  return LanaiImpl::disassemble_offsets_impl<MCInstGPU_Lanai>(
+      q, MCDisassembler, base_addr, content, offsets);
+}
 } // namespace gapstone
\ No newline at end of file
@@ -33,6 +33,32 @@ static DecodeStatus disassemble_instruction(MCInstGPU_LoongArch &MI,
 
   return Result;
 }
+
+static uint8_t get_target(const MCInstGPU_LoongArch &MI, uint64_t Address,
+                          uint64_t &Target) {
+  switch (MI.getOpcode()) {
+  case LoongArch::PCADDI:
+    Target = Address + (MI.getOperand(1).getImm() * 4);
+    return gapstone::TargetKind::Memory;
+  case LoongArch::PCADDU12I:
+    Target = Address + (MI.getOperand(1).getImm() * 4096);
+    return gapstone::TargetKind::Memory;
+  case LoongArch::PCALAU12I:
+    Target = (Address & ~0xfffULL) + (MI.getOperand(1).getImm() * 4096);
+    return gapstone::TargetKind::Page;
+  default:
+    break;
+  }
+  const MCInstrDesc &Desc = getMCID(MI.getOpcode());
+  int Idx = gapstone::getTargetOperand(Desc, MI);
+  if (Idx < 0)
+    return gapstone::TargetKind::None;
+  // Branch offsets are already scaled to bytes by decodeSImmOperand.
+  Target = Address + MI.getOperand(Idx).getImm();
+  return Desc.isCall() ? gapstone::TargetKind::Call
+                       : gapstone::TargetKind::Branch;
+}
+
 #include "DisassembleImpl.h"
 } // namespace LoongArchImpl
 std::unique_ptr<InstInfoContainer> LoongArchDisassembler::batch_disassemble(
@@ -40,4 +66,28 @@ std::unique_ptr<InstInfoContainer> LoongArchDisassembler::batch_disassemble(
   return LoongArchImpl::disassemble_impl<MCInstGPU_LoongArch>(
       q, MCDisassembler, base_addr, content, step_size);
 }
+
+std::unique_ptr<InstInfoContainer>
+LoongArchDisassembler::batch_disassemble_ranges(
+    std::vector<uint8_t> &content, const std::vector<DecodeRange> &ranges,
+    int step_size, const std::vector<uint64_t> *offsets) {
+  return LoongArchImpl::disassemble_ranges_impl<MCInstGPU_LoongArch>(
+      q, MCDisassembler, content, ranges, step_size, offsets);
+}
+
+std::unique_ptr<InstInfoContainer>
+LoongArchDisassembler::batch_disassemble_selected(
+    uint64_t base_addr, std::vector<uint8_t> &content, int step_size,
+    const std::vector<uint64_t> &offsets) {
+  return LoongArchImpl::disassemble_selected_impl<MCInstGPU_LoongArch>(
+      q, MCDisassembler, base_addr, content, step_size, offsets);
+}
+
+std::unique_ptr<InstInfoContainer>
+LoongArchDisassembler::batch_disassemble_offsets(
+    uint64_t base_addr, std::vector<uint8_t> &content,
+    const std::vector<uint64_t> &offsets) {
+  return LoongArchImpl::disassemble_offsets_impl<MCInstGPU_LoongArch>(
+      q, MCDisassembler, base_addr, content, offsets);
+}
 } // namespace gapstone
\ No newline at end of file
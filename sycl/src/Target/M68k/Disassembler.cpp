@@ -43,6 +43,19 @@ static DecodeStatus disassemble_instruction(MCInstGPU_M68k &MI,
     MI.Size = InstrLenTable[MI.getOpcode()] >> 3;
   return Result;
 }
+
+static uint8_t get_target(const MCInstGPU_M68k &MI, uint64_t Address,
+                          uint64_t &Target) {
+  const MCInstrDesc &Desc = getMCID(MI.getOpcode());
+  int Idx = gapstone::getTargetOperand(Desc, MI);
+  if (Idx < 0)
+    return gapstone::TargetKind::None;
+  // Displacements are relative to the extension word following the opcode.
+  Target = Address + 2 + MI.getOperand(Idx).getImm();
+  return Desc.isCall() ? gapstone::TargetKind::Call
+                       : gapstone::TargetKind::Branch;
+}
+
 #include "DisassembleImpl.h"
 } // namespace M68kImpl
 std::unique_ptr<InstInfoContainer> M68kDisassembler::batch_disassemble(
@@ -50,4 +63,28 @@ std::unique_ptr<InstInfoContainer> M68kDisassembler::batch_disassemble(
   return M68kImpl::disassemble_impl<MCInstGPU_M68k>(
       q, MCDisassembler, base_addr, content, step_size);
 }
+
+std::unique_ptr<InstInfoContainer>
+M68kDisassembler::batch_disassemble_ranges(
+    std::vector<uint8_t> &content, const std::vector<DecodeRange> &ranges,
+    int step_size, const std::vector<uint64_t> *offsets) {
+  return M68kImpl::disassemble_ranges_impl<MCInstGPU_M68k>(
+      q, MCDisassembler, content, ranges, step_size, offsets);
+}
+
+std::unique_ptr<InstInfoContainer>
+M68kDisassembler::batch_disassemble_selected(
+    uint64_t base_addr, std::vector<uint8_t> &content, int step_size,
+    const std::vector<uint64_t> &offsets) {
+  return M68kImpl::disassemble_selected_impl<MCInstGPU_M68k>(
+      q, MCDisassembler, base_addr, content, step_size, offsets);
+}
+
+std::unique_ptr<InstInfoContainer>
+M68kDisassembler::batch_disassemble_offsets(
+    uint64_t base_addr, std::vector<uint8_t> &content,
+    const std::vector<uint64_t> &offsets) {
+  return M68kImpl::disassemble_offsets_impl<MCInstGPU_M68k>(
+      q, MCDisassembler, base_addr, content, offsets);
+}
 } // namespace gapstone
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include "X86/X86SyclDisassembler.h"
+#include "Analysis/FunctionStarts.h"
+#include "Analysis/JumpTables.h"
+#include "Analysis/Superset.h"
 #include "Disassembler/X86DisassemblerDecoder.h"
 #include "SyclDisassembler.h"
 #include "X86/Decode.h"
@@ -72,7 +75,91 @@ static DecodeStatus disassemble_instruction(MCInstGPU_X86 &Instr,
   return (!Ret) ? DecodeStatus::Success : DecodeStatus::Fail;
 }
 
+static uint8_t get_target(const MCInstGPU_X86 &Instr, uint64_t Address,
+                          uint64_t &Target) {
+  const MCInstrDesc &Desc = getMCID(Instr.getOpcode());
+  // Both relative immediates and RIP-relative displacements are relative to
+  // the next instruction.
+  uint64_t NextAddress = Address + Instr.Size;
+  int Idx = gapstone::getTargetOperand(Desc, Instr);
+  if (Idx >= 0) {
+    Target = NextAddress + Instr.getOperand(Idx).getImm();
+    return Desc.isCall() ? gapstone::TargetKind::Call
+                         : gapstone::TargetKind::Branch;
+  }
+  // A memory reference is base, scale, index, displacement and segment.
+  for (unsigned I = 0; I + 3 < Instr.getNumOperands(); ++I) {
+    const MCOperand &Op = Instr.getOperand(I);
+    if (!Op.isReg() || (Op.getReg() != X86::RIP && Op.getReg() != X86::EIP))
+      continue;
+    Target = NextAddress + Instr.getOperand(I + 3).getImm();
+    if (Op.getReg() == X86::EIP)
+      Target &= 0xffffffff;
+    return gapstone::TargetKind::Memory;
+  }
+  return gapstone::TargetKind::None;
+}
+
 #include "DisassembleImpl.h"
+
+// Whether the Len bytes at P spell Pattern, most significant byte first.
+static bool match_bytes(const uint8_t *P, uint64_t Left, uint32_t Pattern,
+                        unsigned Len) {
+  if (Left < Len)
+    return false;
+  for (unsigned I = 0; I < Len; ++I)
+    if (P[I] != ((Pattern >> (8 * (Len - 1 - I))) & 0xff))
+      return false;
+  return true;
+}
+
+static bool is_padding(uint8_t Byte) {
+  return Byte == 0xcc || Byte == 0x90 || Byte == 0x00;
+}
+
+// FunctionHint bits of superset entry I, from the raw bytes of common
+// compiler-generated entry sequences.
+static uint32_t get_function_hints(const SupersetView &View,
+                                   const uint8_t *Bytes, uint64_t Size,
+                                   uint64_t I, bool Is64Bit) {
+  if (!View.valid(I))
+    return FunctionHint::None;
+  uint64_t Offset = I * View.step_size;
+  const uint8_t *P = Bytes + Offset;
+  uint64_t Left = Size - Offset;
+  uint32_t Hints = FunctionHint::None;
+  // endbr64 / endbr32
+  if (match_bytes(P, Left, 0xf30f1efa, 4) ||
+      match_bytes(P, Left, 0xf30f1efb, 4))
+    Hints |= FunctionHint::EndBranch;
+  // push rbp; mov rbp, rsp
+  uint64_t Next = View.next(I);
+  if (P[0] == 0x55 && Next != View.tasks) {
+    const uint8_t *Q = Bytes + Next * View.step_size;
+    uint64_t QLeft = Size - Next * View.step_size;
+    if (Is64Bit ? match_bytes(Q, QLeft, 0x4889e5, 3) ||
+                      match_bytes(Q, QLeft, 0x488bec, 3)
+                : match_bytes(Q, QLeft, 0x89e5, 2) ||
+                      match_bytes(Q, QLeft, 0x8bec, 2))
+      Hints |= FunctionHint::FramePrologue;
+  }
+  // sub rsp, imm or a callee-saved push without a frame pointer
+  if (Is64Bit) {
+    if (match_bytes(P, Left, 0x4883ec, 3) ||
+        match_bytes(P, Left, 0x4881ec, 3) || P[0] == 0x53 ||
+        (Left >= 2 && P[0] == 0x41 && P[1] >= 0x54 && P[1] <= 0x57))
+      Hints |= FunctionHint::FramelessPrologue;
+  } else {
+    if (match_bytes(P, Left, 0x83ec, 2) || match_bytes(P, Left, 0x81ec, 2) ||
+        P[0] == 0x53 || P[0] == 0x56 || P[0] == 0x57)
+      Hints |= FunctionHint::FramelessPrologue;
+  }
+  // Aligned code right after int3/nop/zero padding or a return
+  if (!View.starts_range(I) && View.address(I) % 16 == 0 &&
+      !is_padding(P[0]) && (is_padding(P[-1]) || P[-1] == 0xc3))
+    Hints |= FunctionHint::AfterPadding;
+  return Hints;
+}
 } // namespace X86Impl
 
 std::unique_ptr<InstInfoContainer> X86Disassembler::batch_disassemble(
@@ -80,4 +167,100 @@ std::unique_ptr<InstInfoContainer> X86Disassembler::batch_disassemble(
   return X86Impl::disassemble_impl<MCInstGPU_X86>(q, MCDisassembler, base_addr,
                                                   content, step_size);
 }
+
+std::unique_ptr<InstInfoContainer>
+X86Disassembler::batch_disassemble_ranges(
+    std::vector<uint8_t> &content, const std::vector<DecodeRange> &ranges,
+    int step_size, const std::vector<uint64_t> *offsets) {
+  return X86Impl::disassemble_ranges_impl<MCInstGPU_X86>(
+      q, MCDisassembler, content, ranges, step_size, offsets);
+}
+
+std::unique_ptr<InstInfoContainer>
+X86Disassembler::batch_disassemble_selected(
+    uint64_t base_addr, std::vector<uint8_t> &content, int step_size,
+    const std::vector<uint64_t> &offsets) {
+  return X86Impl::disassemble_selected_impl<MCInstGPU_X86>(
+      q, MCDisassembler, base_addr, content, step_size, offsets);
+}
+
+std::unique_ptr<InstInfoContainer>
+X86Disassembler::batch_disassemble_offsets(
+    uint64_t base_addr, std::vector<uint8_t> &content,
+    const std::vector<uint64_t> &offsets) {
+  return X86Impl::disassemble_offsets_impl<MCInstGPU_X86>(
+      q, MCDisassembler, base_addr, content, offsets);
+}
+
+std::vector<FunctionCandidate>
+X86Disassembler::function_starts(InstInfoContainer &insts,
+                                 std::vector<uint8_t> &content) {
+  bool Is64Bit =
+      MCDisassembler.getSubtargetInfo().getFeatureBits()[X86::Is64Bit];
+  DeviceSuperset superset(q, insts);
+  SupersetView view = superset.view();
+  uint64_t size = content.size();
+  uint8_t *bytes = sycl::malloc_device<uint8_t>(size, q);
+  uint32_t *hints = sycl::malloc_device<uint32_t>(view.tasks, q);
+  q.memcpy(bytes, content.data(), size).wait();
+  q.parallel_for(view.tasks, [=](sycl::id<1> i) {
+     hints[i] = X86Impl::get_function_hints(view, bytes, size, i, Is64Bit);
+   }).wait();
+  mark_call_targets(q, view, hints).wait();
+  auto res = collect_function_candidates(q, view, hints);
+  rank_function_candidates(res);
+  sycl::free(hints, q);
+  sycl::free(bytes, q);
+  return res;
+}
+
+std::vector<JumpTable>
+X86Disassembler::find_jump_tables(InstInfoContainer &insts,
+                                  std::vector<uint8_t> &content,
+                                  const std::vector<uint8_t> &mask) {
+  bool Is64Bit =
+      MCDisassembler.getSubtargetInfo().getFeatureBits()[X86::Is64Bit];
+  unsigned PointerSize = Is64Bit ? 8 : 4;
+  uint64_t AddressMask = Is64Bit ? ~uint64_t(0) : 0xffffffff;
+  // Only the few indirect jumps are looked at on the host.
+  SupersetView view = host_view(insts);
+  std::vector<JumpTable> res;
+  for (uint64_t i : collect_indirect_jumps(q, insts, mask)) {
+    llvm::MCInst MI = insts.getMCInst(i);
+    // jmp [table + index * scale]: base, scale, index, displacement, segment.
+    if (MI.getNumOperands() >= 5) {
+      const MCOperand &Base = MI.getOperand(0);
+      const MCOperand &Scale = MI.getOperand(1);
+      const MCOperand &Index = MI.getOperand(2);
+      const MCOperand &Disp = MI.getOperand(3);
+      if (Base.isReg() && Base.getReg() == X86::NoRegister && Scale.isImm() &&
+          Scale.getImm() == PointerSize && Index.isReg() &&
+          Index.getReg() != X86::NoRegister && Disp.isImm())
+        res.push_back({view.address(i), uint64_t(Disp.getImm()) & AddressMask,
+                       0, uint8_t(PointerSize), 0,
+                       JumpTableEncoding::Absolute, 0});
+      continue;
+    }
+    // Position-independent form:
+    //   lea base, [rip + table]
+    //   movsxd entry, dword ptr [base + index * 4]
+    //   add entry, base
+    //   jmp entry
+    if (!Is64Bit)
+      continue;
+    bool Loaded = false;
+    for (uint64_t j : preceding_instructions(view, mask, i, 8)) {
+      if (view.attributes[j] & InstAttr::Load) {
+        Loaded = true;
+        continue;
+      }
+      if (Loaded && view.target_kinds[j] == TargetKind::Memory) {
+        res.push_back({view.address(i), view.targets[j], view.targets[j], 4,
+                       0, JumpTableEncoding::Relative, 0});
+        break;
+      }
+    }
+  }
+  return res;
+}
 } // namespace gapstone
\ No newline at end of file
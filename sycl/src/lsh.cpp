@@ -0,0 +1,90 @@
+// Copyright (C) 2023 Intel Corporation
+
+// SPDX-License-Identifier: MIT
+
+#include "Analysis/MinHash.h"
+#include <boost/program_options.hpp>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace po = boost::program_options;
+
+struct Args {
+  std::string corpus;
+  std::optional<std::string> query;
+  uint32_t bands;
+  float threshold;
+};
+
+std::optional<Args> ParseArgs(int argc, char *argvp[]) {
+  po::options_description desc(
+      "Tool to find similar functions in MinHash signature files");
+  desc.add_options()("corpus", po::value<std::string>(),
+                     "Signature file to index")(
+      "query,q", po::value<std::string>(),
+      "Signature file to look up, the corpus itself by default")(
+      "bands,b", po::value<uint32_t>(), "LSH bands, must divide the signature")(
+      "threshold,t", po::value<float>(),
+      "Minimum estimated similarity to report")("help,h", "Print help");
+  po::positional_options_description p;
+  p.add("corpus", 1);
+
+  po::variables_map vm;
+  po::store(
+      po::command_line_parser(argc, argvp).options(desc).positional(p).run(),
+      vm);
+  po::notify(vm);
+  if (vm.count("help") || !vm.count("corpus")) {
+    std::cout << "Usage: " << argvp[0] << " [options] <corpus>" << std::endl;
+    std::cout << desc << std::endl;
+    return std::nullopt;
+  }
+  return std::make_optional<Args>(Args{
+      vm["corpus"].as<std::string>(),
+      vm.count("query") ? std::make_optional(vm["query"].as<std::string>())
+                        : std::nullopt,
+      vm.count("bands") ? vm["bands"].as<uint32_t>() : 16,
+      vm.count("threshold") ? vm["threshold"].as<float>() : 0.5f,
+  });
+}
+
+static gapstone::MinHashSignatures read_signatures(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+  return gapstone::read_minhash_signatures(in);
+}
+
+int main(int argc, char **argv) {
+  auto args = ParseArgs(argc, argv);
+  if (!args) {
+    return -1;
+  }
+  auto corpus = read_signatures(args->corpus);
+  auto queries = args->query ? read_signatures(*args->query) : corpus;
+  if (queries.num_hashes != corpus.num_hashes) {
+    std::cerr << "Signature lengths differ" << std::endl;
+    return -1;
+  }
+  auto index = gapstone::build_lsh_index(corpus, args->bands);
+  for (uint64_t f = 0; f < queries.size(); ++f) {
+    for (auto g : index.query(queries.signature(f))) {
+      // Report each pair of the corpus once.
+      if (!args->query && g <= f) {
+        continue;
+      }
+      auto similarity = gapstone::estimate_similarity(
+          queries.signature(f), corpus.signature(g), corpus.num_hashes);
+      if (similarity < args->threshold) {
+        continue;
+      }
+      std::cout << "0x" << std::hex << queries.addresses[f] << " 0x"
+                << corpus.addresses[g] << " " << similarity << std::endl;
+    }
+  }
+  return 0;
+}
@@ -2,20 +2,47 @@
 
 // SPDX-License-Identifier: MIT
 
+#include "Analysis/AddressPairs.h"
+#include "Analysis/BaseAddress.h"
+#include "Analysis/CallGraph.h"
+#include "Analysis/CodeProbability.h"
+#include "Analysis/ControlFlow.h"
+#include "Analysis/Diff.h"
+#include "Analysis/EntropyMap.h"
+#include "Analysis/FunctionStarts.h"
+#include "Analysis/Histogram.h"
+#include "Analysis/JumpTables.h"
+#include "Analysis/LinearSweep.h"
+#include "Analysis/LoopNest.h"
+#include "Analysis/MinHash.h"
+#include "Analysis/Padding.h"
+#include "Analysis/Partition.h"
+#include "Analysis/Prune.h"
+#include "Analysis/Sampling.h"
+#include "Analysis/Traversal.h"
+#include "Analysis/Xref.h"
 #include "Disassemblers.h"
+#include "Identify.h"
 #include "LIEF/Abstract/Section.hpp"
 #include "SyclDisassembler.h"
 #include <LIEF/LIEF.hpp>
 #include <access/access.hpp>
+#include <algorithm>
 #include <boost/program_options.hpp>
 #include <device_selector.hpp>
 #include <exception.hpp>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <llvm/MC/MCAsmInfo.h>
 #include <llvm/MC/MCContext.h>
 #include <llvm/MC/MCDecoderOps.h>
 #include <llvm/MC/MCDisassembler/MCDisassembler.h>
 #include <llvm/MC/MCInstPrinter.h>
+#include <llvm/MC/MCInstrAnalysis.h>
 #include <llvm/MC/MCInstrDesc.h>
 #include <llvm/MC/MCInstrInfo.h>
 #include <llvm/MC/MCRegisterInfo.h>
@@ -24,6 +51,7 @@
 #include <llvm/MC/TargetRegistry.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/TargetParser/Triple.h>
+#include <sstream>
 #include <sycl/sycl.hpp>
 
 using namespace sycl;
@@ -40,6 +68,28 @@ struct Args {
   int step_size;
   bool naive;
   bool print;
+  bool functions;
+  bool prune;
+  bool probabilities;
+  bool traverse;
+  bool edges;
+  bool jump_tables;
+  bool blocks;
+  std::optional<std::string> call_graph;
+  std::optional<std::string> signatures;
+  std::vector<std::string> xrefs;
+  std::optional<unsigned> address_pairs;
+  std::optional<unsigned> histogram;
+  bool histogram_by_function;
+  std::vector<std::string> diff;
+  bool identify;
+  std::optional<uint64_t> infer_base;
+  std::optional<double> sample;
+  bool sample_random;
+  std::optional<uint64_t> heatmap;
+  std::optional<float> skip_packed;
+  std::optional<uint64_t> skip_padding;
+  std::vector<std::string> decode_at;
 };
 
 std::optional<Args> ParseArgs(int argc, char *argvp[]) {
@@ -51,7 +101,48 @@ std::optional<Args> ParseArgs(int argc, char *argvp[]) {
       "features,r", po::value<std::string>(),
       "Features")("step_size,s", po::value<int>(),
                   "Step Size")("naive,n", "Use naive implementation")(
-      "print,p", "Print Instructions")("help,h", "Print help");
+      "print,p", "Print Instructions")(
+      "functions", "Print ranked function start candidates")(
+      "prune", "Print how many offsets survive invalid-chain pruning")(
+      "probabilities", "Print the probability of every decodable offset "
+                       "being a true instruction start")(
+      "traverse", "Print instructions reachable from the entry points "
+                  "instead of the linear sweep")(
+      "edges", "Print control-flow edges between the selected instructions")(
+      "jump_tables", "Recover jump tables and add their targets as "
+                     "control-flow edges")(
+      "blocks", "Print basic blocks and loop depth grouped by function")(
+      "call_graph", po::value<std::string>(),
+      "Write the call graph to a .graphml or .dot file")(
+      "signatures", po::value<std::string>(),
+      "Write per-function MinHash signatures to a file for gapstone-lsh")(
+      "xref,x", po::value<std::vector<std::string>>(),
+      "Print the instructions referring to an address")(
+      "address_pairs", po::value<unsigned>()->implicit_value(8),
+      "Print addresses built by adrp-style pairs within a window")(
+      "histogram", po::value<unsigned>()->implicit_value(1),
+      "Print opcode (1) or hashed opcode 2-/3-gram counts")(
+      "histogram_by_function", "Print one histogram per function")(
+      "diff", po::value<std::vector<std::string>>()->multitoken(),
+      "Diff the functions of two builds: --diff OLD NEW")(
+      "identify", "Rank the architectures the raw file may be code for")(
+      "infer_base", po::value<uint64_t>()->implicit_value(0x1000),
+      "Rank load addresses of the raw file, at the given alignment")(
+      "sample", po::value<double>(),
+      "Estimate code ratio, opcode mix and architecture of the raw file "
+      "from this share of its offsets")(
+      "sample_random", "Draw the --sample offsets at random instead of one "
+                       "per stratum")(
+      "heatmap", po::value<uint64_t>()->implicit_value(4096),
+      "Print byte entropy and decode density per window of this many bytes")(
+      "skip_packed", po::value<float>()->implicit_value(7.2f),
+      "Do not decode windows above this entropy in bits per byte")(
+      "skip_padding", po::value<uint64_t>()->implicit_value(8),
+      "Do not decode 0x00, int3 and nop runs of at least this many bytes, "
+      "and report their ends as function start hints")(
+      "decode_at", po::value<std::vector<std::string>>()->multitoken(),
+      "Print only the instructions at these addresses")(
+      "help,h", "Print help");
   po::positional_options_description p;
   p.add("file_path", 1);
 
@@ -60,13 +151,31 @@ std::optional<Args> ParseArgs(int argc, char *argvp[]) {
       po::command_line_parser(argc, argvp).options(desc).positional(p).run(),
       vm);
   po::notify(vm);
-  if (vm.count("help") || argc == 1) {
+  auto diff = vm.count("diff") ? vm["diff"].as<std::vector<std::string>>()
+                               : std::vector<std::string>();
+  if (!diff.empty() && diff.size() != 2) {
+    std::cout << "--diff takes exactly two files" << std::endl;
+    return std::nullopt;
+  }
+  if (vm.count("histogram") && (vm["histogram"].as<unsigned>() < 1 ||
+                                vm["histogram"].as<unsigned>() >
+                                    gapstone::MaxNgram)) {
+    std::cout << "--histogram takes an n-gram order from 1 to "
+              << gapstone::MaxNgram << std::endl;
+    return std::nullopt;
+  }
+  if (vm.count("heatmap") && vm["heatmap"].as<uint64_t>() == 0) {
+    std::cout << "--heatmap takes a window of at least one byte" << std::endl;
+    return std::nullopt;
+  }
+  if (vm.count("help") || argc == 1 ||
+      (!vm.count("file_path") && diff.empty())) {
     std::cout << "Usage: " << argvp[0] << " [options] <file_path>" << std::endl;
     std::cout << desc << std::endl;
     return std::nullopt;
   }
   return std::make_optional<Args>(Args{
-      vm["file_path"].as<std::string>(),
+      vm.count("file_path") ? vm["file_path"].as<std::string>() : diff[0],
       vm.count("triple") ? std::make_optional(vm["triple"].as<std::string>())
                          : std::nullopt,
       vm.count("cpu") ? vm["cpu"].as<std::string>() : "",
@@ -74,6 +183,46 @@ std::optional<Args> ParseArgs(int argc, char *argvp[]) {
       vm.count("step_size") ? vm["step_size"].as<int>() : 1,
       vm.count("naive") ? true : false,
       vm.count("print") ? true : false,
+      vm.count("functions") ? true : false,
+      vm.count("prune") ? true : false,
+      vm.count("probabilities") ? true : false,
+      vm.count("traverse") ? true : false,
+      vm.count("edges") ? true : false,
+      vm.count("jump_tables") ? true : false,
+      vm.count("blocks") ? true : false,
+      vm.count("call_graph")
+          ? std::make_optional(vm["call_graph"].as<std::string>())
+          : std::nullopt,
+      vm.count("signatures")
+          ? std::make_optional(vm["signatures"].as<std::string>())
+          : std::nullopt,
+      vm.count("xref") ? vm["xref"].as<std::vector<std::string>>()
+                       : std::vector<std::string>(),
+      vm.count("address_pairs")
+          ? std::make_optional(vm["address_pairs"].as<unsigned>())
+          : std::nullopt,
+      vm.count("histogram")
+          ? std::make_optional(vm["histogram"].as<unsigned>())
+          : std::nullopt,
+      vm.count("histogram_by_function") ? true : false,
+      diff,
+      vm.count("identify") ? true : false,
+      vm.count("infer_base")
+          ? std::make_optional(vm["infer_base"].as<uint64_t>())
+          : std::nullopt,
+      vm.count("sample") ? std::make_optional(vm["sample"].as<double>())
+                         : std::nullopt,
+      vm.count("sample_random") ? true : false,
+      vm.count("heatmap") ? std::make_optional(vm["heatmap"].as<uint64_t>())
+                          : std::nullopt,
+      vm.count("skip_packed")
+          ? std::make_optional(vm["skip_packed"].as<float>())
+          : std::nullopt,
+      vm.count("skip_padding")
+          ? std::make_optional(vm["skip_padding"].as<uint64_t>())
+          : std::nullopt,
+      vm.count("decode_at") ? vm["decode_at"].as<std::vector<std::string>>()
+                            : std::vector<std::string>(),
   });
 }
 
@@ -95,23 +244,341 @@ disassemble(std::unique_ptr<llvm::MCDisassembler> &disassembler,
   return insn;
 }
 
+// Decodes every range of content on the host, entry i describing the
+// offset i * step_size as batch_disassemble_ranges does.
 std::unique_ptr<gapstone::InstInfoContainer>
 batch_disassemble(std::unique_ptr<llvm::MCDisassembler> &disassembler,
-                  const llvm::ArrayRef<uint8_t> &data, uint64_t base_addr,
+                  const llvm::MCInstrInfo &instr_info,
+                  const llvm::MCInstrAnalysis *instr_analysis,
+                  const std::vector<uint8_t> &content,
+                  const std::vector<gapstone::DecodeRange> &ranges,
                   int step_size) {
-  auto tasks = data.size() / step_size;
+  auto tasks = content.size() / step_size;
   // std::vector<gapstone::InstInfo> insts(tasks);
   auto insts_info = std::make_unique<gapstone::InstInfoContainerCPU>(tasks);
-  for (int i = 0; i < tasks; ++i) {
-    auto offset = i * step_size;
-    uint64_t insn_size = 0;
-    insts_info->status[i] = disassembler->getInstruction(
-        insts_info->insts[i], insn_size, data.slice(offset), base_addr + offset,
-        llvm::nulls());
+  insts_info->base_addr = ranges.empty() ? 0 : ranges[0].address;
+  insts_info->step_size = step_size;
+  insts_info->ranges = ranges;
+  const llvm::ArrayRef<uint8_t> data(content);
+  for (auto &range : ranges) {
+    auto bytes = data.slice(range.offset, range.size);
+    for (uint64_t offset = 0; offset < range.size; offset += step_size) {
+      auto i = (range.offset + offset) / step_size;
+      auto address = range.address + offset;
+      uint64_t insn_size = 0;
+      insts_info->status[i] = disassembler->getInstruction(
+          insts_info->insts[i], insn_size, bytes.slice(offset), address,
+          llvm::nulls());
+      if (insts_info->status[i] == llvm::MCDisassembler::Fail) {
+        continue;
+      }
+      insts_info->sizes[i] = insn_size;
+      auto &inst = insts_info->insts[i];
+      insts_info->opcodes[i] = inst.getOpcode();
+      insts_info->attributes[i] =
+          gapstone::getInstAttributes(instr_info.get(inst.getOpcode()));
+      if (!instr_analysis) {
+        continue;
+      }
+      uint64_t target = 0;
+      if (instr_analysis->evaluateBranch(inst, address, insn_size, target)) {
+        insts_info->targets[i] = target;
+        insts_info->target_kinds[i] = instr_analysis->isCall(inst)
+                                          ? gapstone::TargetKind::Call
+                                          : gapstone::TargetKind::Branch;
+      } else if (auto memory = instr_analysis->evaluateMemoryOperandAddress(
+                     inst, &disassembler->getSubtargetInfo(), address,
+                     insn_size)) {
+        insts_info->targets[i] = *memory;
+        insts_info->target_kinds[i] = gapstone::TargetKind::Memory;
+      } else if (instr_info.get(inst.getOpcode()).isMoveImmediate()) {
+        int imm = gapstone::getImmediateOperand(inst);
+        if (imm >= 0) {
+          insts_info->targets[i] = inst.getOperand(imm).getImm();
+          insts_info->target_kinds[i] = gapstone::TargetKind::Immediate;
+        }
+      }
+    }
   }
   return insts_info;
 }
 
+// Address the image is linked at. PE section and export addresses are
+// relative to it.
+uint64_t image_base(LIEF::Binary &binary) {
+  if (auto *pe = dynamic_cast<LIEF::PE::Binary *>(&binary)) {
+    return pe->optional_header().imagebase();
+  }
+  return 0;
+}
+
+// Addresses recursive traversal starts from: the entry point, every defined
+// function symbol and every exported function. Object and section symbols
+// point at data. PE exports are relative to the image base, the entry point
+// LIEF reports is not.
+std::vector<uint64_t> collect_entry_points(LIEF::Binary &binary) {
+  std::vector<uint64_t> entries{binary.entrypoint()};
+  if (auto *elf = dynamic_cast<LIEF::ELF::Binary *>(&binary)) {
+    for (auto &symbol : elf->symbols()) {
+      if (symbol.is_function() && symbol.value() != 0) {
+        entries.push_back(symbol.value());
+      }
+    }
+  }
+  if (auto *macho = dynamic_cast<LIEF::MachO::Binary *>(&binary)) {
+    // Mach-O does not type its symbols; those defined in a section, other
+    // than debugging entries, are taken.
+    constexpr uint8_t stab_mask = 0xe0, type_mask = 0x0e, in_section = 0x0e;
+    for (auto &symbol : macho->symbols()) {
+      if (!(symbol.type() & stab_mask) &&
+          (symbol.type() & type_mask) == in_section && symbol.value() != 0) {
+        entries.push_back(symbol.value());
+      }
+    }
+  }
+  if (auto *pe = dynamic_cast<LIEF::PE::Binary *>(&binary)) {
+    // COFF symbol values are relative to their 1-based section.
+    auto sections = pe->sections();
+    for (auto &symbol : pe->symbols()) {
+      auto number = symbol.section_number();
+      if (symbol.complex_type() !=
+              LIEF::PE::SYMBOL_COMPLEX_TYPES::IMAGE_SYM_DTYPE_FUNCTION ||
+          number <= 0 || uint64_t(number) > sections.size()) {
+        continue;
+      }
+      entries.push_back(image_base(binary) +
+                        sections[number - 1].virtual_address() +
+                        symbol.value());
+    }
+  }
+  for (auto &function : binary.exported_functions()) {
+    entries.push_back(image_base(binary) + function.address());
+  }
+  return entries;
+}
+
+// A range of the image holding code.
+struct CodeRegion {
+  std::string name;
+  uint64_t address;
+  std::vector<uint8_t> content;
+};
+
+// Whether the section is mapped at run time. Non-ELF formats do not flag
+// this, there the unmapped sections are the ones at address 0.
+bool is_allocated(LIEF::Section &section) {
+  if (auto *elf = dynamic_cast<LIEF::ELF::Section *>(&section)) {
+    return elf->has(LIEF::ELF::ELF_SECTION_FLAGS::SHF_ALLOC);
+  }
+  return section.virtual_address() != 0;
+}
+
+bool is_executable(LIEF::Section &section) {
+  if (auto *elf = dynamic_cast<LIEF::ELF::Section *>(&section)) {
+    return elf->has(LIEF::ELF::ELF_SECTION_FLAGS::SHF_EXECINSTR);
+  }
+  if (auto *pe = dynamic_cast<LIEF::PE::Section *>(&section)) {
+    return pe->has_characteristic(
+        LIEF::PE::SECTION_CHARACTERISTICS::IMAGE_SCN_MEM_EXECUTE);
+  }
+  if (auto *macho = dynamic_cast<LIEF::MachO::Section *>(&section)) {
+    return macho->has(
+               LIEF::MachO::MACHO_SECTION_FLAGS::S_ATTR_PURE_INSTRUCTIONS) ||
+           macho->has(
+               LIEF::MachO::MACHO_SECTION_FLAGS::S_ATTR_SOME_INSTRUCTIONS);
+  }
+  return section.name() == ".text";
+}
+
+// Executable sections, or the executable segments of an ELF image without
+// section headers.
+std::vector<CodeRegion> collect_code_regions(LIEF::Binary &binary) {
+  std::vector<CodeRegion> regions;
+  for (auto &section : binary.sections()) {
+    auto content = section.content();
+    if (is_executable(section) && !content.empty()) {
+      regions.push_back({section.name(),
+                         image_base(binary) + section.virtual_address(),
+                         {content.begin(), content.end()}});
+    }
+  }
+  auto *elf = dynamic_cast<LIEF::ELF::Binary *>(&binary);
+  if (regions.empty() && elf) {
+    for (auto &segment : elf->segments()) {
+      auto content = segment.content();
+      if (segment.type() == LIEF::ELF::SEGMENT_TYPES::PT_LOAD &&
+          segment.has(LIEF::ELF::ELF_SEGMENT_FLAGS::PF_X) &&
+          !content.empty()) {
+        regions.push_back({"segment", segment.virtual_address(),
+                           {content.begin(), content.end()}});
+      }
+    }
+  }
+  return regions;
+}
+
+// The code regions packed one after the other at step-aligned offsets, and
+// the table batch_disassemble_ranges decodes them through. Only the bytes of
+// the regions are held, however far apart they are loaded.
+struct PackedCode {
+  // The section name of every range.
+  std::vector<std::string> names;
+  std::vector<uint8_t> content;
+  std::vector<gapstone::DecodeRange> ranges;
+};
+
+// Regions sharing addresses, such as the sections of a relocatable object
+// that all sit at address 0, become ranges of their own.
+PackedCode pack_code_regions(std::vector<CodeRegion> &regions,
+                             int step_size) {
+  std::stable_sort(regions.begin(), regions.end(),
+                   [](const CodeRegion &a, const CodeRegion &b) {
+                     return a.address < b.address;
+                   });
+  PackedCode res;
+  for (auto &region : regions) {
+    res.ranges.push_back(
+        {region.address, res.content.size(), region.content.size()});
+    res.content.insert(res.content.end(), region.content.begin(),
+                       region.content.end());
+    res.content.resize((res.content.size() + step_size - 1) / step_size *
+                       step_size);
+    res.names.push_back(region.name);
+  }
+  return res;
+}
+
+// Whether the loader fills the slot of relocation with the address of its
+// symbol: the JUMP_SLOT relocations of the PLT GOT, and GLOB_DAT.
+bool is_import_relocation(LIEF::ELF::Relocation &relocation) {
+  if (relocation.purpose() ==
+      LIEF::ELF::RELOCATION_PURPOSES::RELOC_PURPOSE_PLTGOT) {
+    return true;
+  }
+  switch (relocation.architecture()) {
+  case LIEF::ELF::ARCH::EM_X86_64:
+    return relocation.type() ==
+           uint32_t(LIEF::ELF::RELOC_x86_64::R_X86_64_GLOB_DAT);
+  case LIEF::ELF::ARCH::EM_386:
+    return relocation.type() == uint32_t(LIEF::ELF::RELOC_i386::R_386_GLOB_DAT);
+  case LIEF::ELF::ARCH::EM_AARCH64:
+    return relocation.type() ==
+           uint32_t(LIEF::ELF::RELOC_AARCH64::R_AARCH64_GLOB_DAT);
+  default:
+    return false;
+  }
+}
+
+// Slots the loader fills with imported symbols: the ELF GOT entries with a
+// JUMP_SLOT or GLOB_DAT relocation and the PE import address table.
+std::vector<gapstone::ImportSlot> collect_import_slots(LIEF::Binary &binary) {
+  std::vector<gapstone::ImportSlot> slots;
+  if (auto *elf = dynamic_cast<LIEF::ELF::Binary *>(&binary)) {
+    for (auto &relocation : elf->relocations()) {
+      if (is_import_relocation(relocation) && relocation.has_symbol() &&
+          !relocation.symbol()->name().empty()) {
+        slots.push_back({relocation.address(), relocation.symbol()->name()});
+      }
+    }
+  }
+  if (auto *pe = dynamic_cast<LIEF::PE::Binary *>(&binary)) {
+    for (auto &import : pe->imports()) {
+      for (auto &entry : import.entries()) {
+        if (!entry.name().empty()) {
+          slots.push_back({image_base(binary) + entry.iat_address(),
+                           entry.name()});
+        }
+      }
+    }
+  }
+  return slots;
+}
+
+// Opcodes are their own bin, n-grams are hashed.
+uint32_t histogram_bins(const llvm::MCInstrInfo &instr_info, unsigned ngram) {
+  return ngram == 1 ? instr_info.getNumOpcodes() : gapstone::NgramBins;
+}
+
+void print_histogram(const llvm::MCInstrInfo &instr_info, unsigned ngram,
+                     const gapstone::FeatureHistograms &histograms,
+                     uint64_t group) {
+  auto counts = histograms.histogram(group);
+  for (uint32_t bin = 0; bin < histograms.num_bins; ++bin) {
+    if (!counts[bin]) {
+      continue;
+    }
+    if (ngram == 1) {
+      std::cout << "  " << instr_info.getName(bin).str();
+    } else {
+      std::cout << "  " << std::dec << bin;
+    }
+    std::cout << " " << std::dec << counts[bin] << std::endl;
+  }
+}
+
+// The code regions of a binary, decoded in one launch and partitioned into
+// functions.
+struct DecodedProgram {
+  std::unique_ptr<LIEF::Binary> binary;
+  std::unique_ptr<gapstone::InstInfoContainer> insts;
+  gapstone::ProgramPartition partition;
+};
+
+DecodedProgram decode_program(sycl::queue &q,
+                        gapstone::SyclDisassembler &gapstone_disassembler,
+                        const std::string &path, const Args &args) {
+  DecodedProgram res;
+  res.binary = LIEF::Parser::parse(path);
+  if (!res.binary) {
+    throw std::invalid_argument("Cannot parse " + path);
+  }
+  auto regions = collect_code_regions(*res.binary);
+  auto code = pack_code_regions(regions, args.step_size);
+  if (code.ranges.empty()) {
+    throw std::invalid_argument("No code in " + path);
+  }
+  res.insts = gapstone_disassembler.batch_disassemble_ranges(
+      code.content, code.ranges, args.step_size);
+  auto indices = args.traverse
+                     ? gapstone::recursive_traversal(
+                           q, *res.insts, collect_entry_points(*res.binary))
+                     : gapstone::linear_sweep(q, *res.insts);
+  std::vector<uint8_t> mask(res.insts->status.size());
+  for (auto i : indices) {
+    mask[i] = 1;
+  }
+  auto cfg = gapstone::build_control_flow_graph(q, *res.insts, mask);
+  res.partition = gapstone::partition_program(q, *res.insts, cfg, mask);
+  return res;
+}
+
+void print_diff_instruction(llvm::MCInstPrinter &printer,
+                            const llvm::MCSubtargetInfo &subtarget_info,
+                            gapstone::InstInfoContainer &insts, uint64_t i,
+                            char op) {
+  auto address = insts.address(i);
+  std::string insn_str;
+  llvm::raw_string_ostream str_stream(insn_str);
+  auto inst = insts.getMCInst(i);
+  printer.printInst(&inst, address, "", subtarget_info, str_stream);
+  std::cout << "  " << op << " 0x" << std::hex << address << " "
+            << str_stream.str() << std::endl;
+}
+
+// Four decimals, formatted apart so that std::cout keeps printing addresses
+// and counts as before.
+std::string format_fixed(double value) {
+  std::ostringstream res;
+  res << std::fixed << std::setprecision(4) << value;
+  return res.str();
+}
+
+void print_proportion(const char *name, const gapstone::Proportion &share) {
+  std::cout << name << " " << format_fixed(share.estimate) << " ["
+            << format_fixed(share.low) << ", " << format_fixed(share.high)
+            << "]" << std::endl;
+}
+
 int main(int argc, char **argv) {
   llvm::InitializeAllTargetInfos();
   llvm::InitializeAllTargetMCs();
@@ -125,6 +592,20 @@ int main(int argc, char **argv) {
   if (!args) {
     return -1;
   }
+  if (args->identify) {
+    std::ifstream in(args->file_path, std::ios::binary);
+    std::vector<uint8_t> blob{std::istreambuf_iterator<char>(in),
+                              std::istreambuf_iterator<char>()};
+    for (auto &guess : gapstone::identify_architecture(q, blob)) {
+      std::cout << std::left << std::setw(24) << guess.candidate.name
+                << std::right << " score " << format_fixed(guess.score)
+                << " valid " << format_fixed(guess.validity)
+                << " concentration " << format_fixed(guess.concentration)
+                << " branches " << format_fixed(guess.branch_consistency)
+                << std::endl;
+    }
+    return 0;
+  }
   auto binary = LIEF::Parser::parse(args->file_path);
   auto triple = llvm::Triple(llvm::Triple::normalize(*args->triple));
   std::string lookup_target_error;
@@ -180,6 +661,10 @@ int main(int argc, char **argv) {
     return -1;
   }
 
+  // Optional, only used to resolve targets on the naive path
+  auto instruction_analysis = std::unique_ptr<llvm::MCInstrAnalysis>(
+      target->createMCInstrAnalysis(instruction_info.get()));
+
   // Create disassembler
   auto disassembler = std::unique_ptr<llvm::MCDisassembler>(
       target->createMCDisassembler(*subtarget_info, context));
@@ -188,42 +673,373 @@ int main(int argc, char **argv) {
   }
 
   auto gapstone_disassembler = gapstone::createDisassembler(*disassembler, q);
+  if (args->infer_base) {
+    // Headerless firmware: decode the whole file as if loaded at 0.
+    std::ifstream in(args->file_path, std::ios::binary);
+    std::vector<uint8_t> image{std::istreambuf_iterator<char>(in),
+                               std::istreambuf_iterator<char>()};
+    auto insts_info =
+        gapstone_disassembler->batch_disassemble(0, image, args->step_size);
+    gapstone::BaseSearch search;
+    search.alignment = *args->infer_base;
+    search.pointer_size = triple.isArch64Bit() ? 8 : 4;
+    search.big_endian = !triple.isLittleEndian();
+    for (auto &candidate :
+         gapstone::infer_base_address(q, *insts_info, image, search)) {
+      std::cout << "0x" << std::hex << candidate.base << " " << std::dec
+                << candidate.hits << std::endl;
+    }
+    return 0;
+  }
+  if (args->sample) {
+    // Triage: decode a share of the raw file rather than every offset.
+    std::ifstream in(args->file_path, std::ios::binary);
+    std::vector<uint8_t> blob{std::istreambuf_iterator<char>(in),
+                              std::istreambuf_iterator<char>()};
+    auto mode = args->sample_random ? gapstone::SampleMode::Random
+                                    : gapstone::SampleMode::Stratified;
+    auto offsets = gapstone::sample_offsets(blob.size(), args->step_size,
+                                            *args->sample, mode);
+    auto estimate = gapstone::estimate_from_sample(*gapstone_disassembler, 0,
+                                                   blob, offsets);
+    std::cout << "Samples " << std::dec << estimate.samples << " of "
+              << blob.size() / args->step_size << std::endl;
+    print_proportion("decodes", estimate.decodes);
+    print_proportion("code ratio", estimate.code);
+    print_proportion("branch consistency", estimate.branch_consistency);
+    for (auto &share : estimate.opcode_mix) {
+      std::cout << "  " << instruction_info->getName(share.opcode).str();
+      print_proportion("", share.share);
+    }
+    for (auto &guess :
+         gapstone::identify_architecture(q, blob, 0, *args->sample, mode)) {
+      std::cout << std::left << std::setw(24) << guess.candidate.name
+                << std::right << " score " << format_fixed(guess.score)
+                << " valid " << format_fixed(guess.validity) << " ["
+                << format_fixed(guess.validity_low) << ", "
+                << format_fixed(guess.validity_high) << "]" << std::endl;
+    }
+    return 0;
+  }
+  if (!args->diff.empty()) {
+    // Both builds decode concurrently, sharing the queue.
+    auto old_program =
+        std::async(std::launch::async, decode_program, std::ref(q),
+                   std::ref(*gapstone_disassembler), args->diff[0],
+                   std::cref(*args));
+    auto new_program =
+        std::async(std::launch::async, decode_program, std::ref(q),
+                   std::ref(*gapstone_disassembler), args->diff[1],
+                   std::cref(*args));
+    auto old_decoded = old_program.get();
+    auto new_decoded = new_program.get();
+    auto &old_partition = old_decoded.partition;
+    auto &new_partition = new_decoded.partition;
+    auto diff = gapstone::diff_programs(*old_decoded.insts, old_partition,
+                                        *new_decoded.insts, new_partition);
+    for (auto &match : diff.matches) {
+      if (match.edits.empty()) {
+        continue;
+      }
+      std::cout << "function 0x" << std::hex
+                << old_partition.functions[match.old_function].entry
+                << " -> 0x"
+                << new_partition.functions[match.new_function].entry
+                << (match.kind == gapstone::MatchKind::Hash ? " hash"
+                                                            : " position")
+                << std::endl;
+      for (auto &edit : match.edits) {
+        if (edit.op == gapstone::DiffOp::Delete) {
+          print_diff_instruction(*instruction_printer, *subtarget_info,
+                                 *old_decoded.insts, edit.old_entry, '-');
+        } else if (edit.op == gapstone::DiffOp::Insert) {
+          print_diff_instruction(*instruction_printer, *subtarget_info,
+                                 *new_decoded.insts, edit.new_entry, '+');
+        }
+      }
+    }
+    for (auto f : diff.removed) {
+      std::cout << "removed function 0x" << std::hex
+                << old_partition.functions[f].entry << std::endl;
+    }
+    for (auto f : diff.added) {
+      std::cout << "added function 0x" << std::hex
+                << new_partition.functions[f].entry << std::endl;
+    }
+    return 0;
+  }
+
   std::cout << "Processing Arch " << to_string(binary->header().architecture())
             << std::endl;
-  for (auto &section : binary->sections()) {
-    if (section.name() != ".text") {
-      continue;
+  auto regions = collect_code_regions(*binary);
+  if (!args->decode_at.empty()) {
+    std::vector<uint64_t> addresses;
+    for (auto &address : args->decode_at) {
+      addresses.push_back(std::stoull(address, nullptr, 0));
     }
-    std::cout << "Handling section " << section.name() << std::endl;
-    auto base_addr = section.virtual_address();
-    auto content = section.content();
-    std::unique_ptr<gapstone::InstInfoContainer> insts_info;
-    if (args->naive) {
-      const llvm::ArrayRef<uint8_t> data(content.begin(), content.end());
-      insts_info =
-          batch_disassemble(disassembler, data, base_addr, args->step_size);
-    } else {
-      std::vector<uint8_t> content_vector{content.begin(), content.end()};
-      insts_info = gapstone_disassembler->batch_disassemble(
-          base_addr, content_vector, args->step_size);
-    }
-    if (args->print) {
-      auto tasks = content.size() / args->step_size;
-      for (int i = 0; i < tasks; ++i) {
-        if (insts_info->status[i] !=
-            llvm::MCDisassembler::DecodeStatus::Success) {
+    std::sort(addresses.begin(), addresses.end());
+    // One launch per region for all the addresses it holds.
+    for (auto &region : regions) {
+      auto first = std::lower_bound(addresses.begin(), addresses.end(),
+                                    region.address);
+      auto last = std::lower_bound(first, addresses.end(),
+                                   region.address + region.content.size());
+      std::vector<uint64_t> inside(first, last);
+      if (inside.empty()) {
+        continue;
+      }
+      auto insts = gapstone_disassembler->disassemble_addresses(
+          region.address, region.content, inside);
+      for (uint64_t k = 0; k < inside.size(); ++k) {
+        std::cout << "0x" << std::hex << inside[k] << " ";
+        if (insts->status[k] == llvm::MCDisassembler::Fail) {
+          std::cout << "<invalid>" << std::endl;
           continue;
         }
-        std::cout << "0x" << std::hex << base_addr + args->step_size * i << " "
-                  << std::flush;
         std::string insn_str;
         llvm::raw_string_ostream str_stream(insn_str);
-        auto inst = insts_info->getMCInst(i);
-        instruction_printer->printInst(
-            &inst,
-            /* Address */ base_addr + args->step_size * i,
-            /* Annot */ "", *subtarget_info, str_stream);
-        std::cout << insn_str << std::endl;
+        auto inst = insts->getMCInst(k);
+        instruction_printer->printInst(&inst, inside[k], "", *subtarget_info,
+                                       str_stream);
+        std::cout << str_stream.str() << std::endl;
+      }
+    }
+    return 0;
+  }
+  // All regions are decoded and analysed together, in one launch.
+  auto code = pack_code_regions(regions, args->step_size);
+  if (code.ranges.empty()) {
+    return 0;
+  }
+  std::cout << "Handling sections";
+  for (auto &name : code.names) {
+    std::cout << " " << name;
+  }
+  std::cout << std::endl;
+  std::unique_ptr<gapstone::InstInfoContainer> insts_info;
+  gapstone::PaddingScan padding;
+  if (args->naive) {
+    insts_info = batch_disassemble(disassembler, *instruction_info,
+                                   instruction_analysis.get(), code.content,
+                                   code.ranges, args->step_size);
+  } else if (args->skip_packed) {
+    // Compressed or encrypted windows are left undecoded.
+    auto map = gapstone::entropy_map(
+        q, code.content, args->heatmap.value_or(gapstone::EntropyWindowSize));
+    auto windows = gapstone::decodable_windows(map, *args->skip_packed);
+    std::cout << "Skipping " << std::dec
+              << std::count(windows.begin(), windows.end(), 0) << " of "
+              << windows.size() << " windows" << std::endl;
+    insts_info = gapstone_disassembler->batch_disassemble_ranges(
+        code.content,
+        gapstone::decodable_ranges(map, windows, code.ranges, args->step_size),
+        args->step_size);
+    // The skipped windows read as failed decodes of their regions.
+    insts_info->ranges = code.ranges;
+  } else if (args->skip_padding) {
+    padding = gapstone::scan_padding(
+        q, code.content, args->step_size,
+        gapstone::nop_patterns(triple.getArch()), *args->skip_padding);
+    padding.runs = gapstone::clip_padding_runs(padding.runs, code.ranges);
+    std::cout << "Skipping " << std::dec
+              << code.content.size() / args->step_size -
+                     padding.offsets.size()
+              << " offsets in " << padding.runs.size() << " padding runs"
+              << std::endl;
+    insts_info = gapstone_disassembler->batch_disassemble_ranges(
+        code.content, code.ranges, args->step_size, &padding.offsets);
+  } else {
+    insts_info = gapstone_disassembler->batch_disassemble_ranges(
+        code.content, code.ranges, args->step_size);
+  }
+  if (args->heatmap) {
+    auto map = gapstone::entropy_map(q, *insts_info, code.content,
+                                     *args->heatmap);
+    gapstone::write_heatmap(std::cout, map, 0, code.ranges);
+  }
+  // The linear-sweep instruction stream, or what is reachable from the
+  // entry points, rather than every decodable offset.
+  std::vector<uint64_t> indices;
+  bool partition_needed = args->blocks || args->call_graph ||
+                          args->signatures ||
+                          (args->histogram && args->histogram_by_function);
+  bool selection_needed = args->print || args->edges || partition_needed ||
+                          args->jump_tables || !args->xrefs.empty() ||
+                          args->histogram;
+  if (selection_needed) {
+    indices = args->traverse
+                  ? gapstone::recursive_traversal(
+                        q, *insts_info, collect_entry_points(*binary))
+                  : gapstone::linear_sweep(q, *insts_info);
+  }
+  if (args->print) {
+    for (auto i : indices) {
+      if (insts_info->status[i] !=
+          llvm::MCDisassembler::DecodeStatus::Success) {
+        continue;
+      }
+      std::cout << "0x" << std::hex << insts_info->address(i) << " "
+                << std::flush;
+      std::string insn_str;
+      llvm::raw_string_ostream str_stream(insn_str);
+      auto inst = insts_info->getMCInst(i);
+      instruction_printer->printInst(
+          &inst,
+          /* Address */ insts_info->address(i),
+          /* Annot */ "", *subtarget_info, str_stream);
+      std::cout << insn_str << std::endl;
+    }
+  }
+  std::vector<uint8_t> mask(insts_info->status.size());
+  for (auto i : indices) {
+    mask[i] = 1;
+  }
+  if (!args->xrefs.empty()) {
+    // Immediates only count as references when they point into the mapped
+    // image.
+    uint64_t image_low = UINT64_MAX, image_high = 0;
+    for (auto &image_section : binary->sections()) {
+      if (!is_allocated(image_section)) {
+        continue;
+      }
+      uint64_t address =
+          image_base(*binary) + image_section.virtual_address();
+      image_low = std::min(image_low, address);
+      image_high = std::max(image_high, address + image_section.size());
+    }
+    auto xrefs = gapstone::build_xref_index(q, *insts_info, mask, image_low,
+                                            image_high);
+    for (auto &xref : args->xrefs) {
+      auto address = std::stoull(xref, nullptr, 0);
+      auto [first, last] = xrefs.find(address);
+      std::cout << "References to 0x" << std::hex << address << std::endl;
+      for (auto k = first; k < last; ++k) {
+        std::cout << "  0x" << std::hex << xrefs.sources[k] << std::endl;
+      }
+    }
+  }
+  if (args->edges || args->jump_tables || partition_needed) {
+    auto cfg = gapstone::build_control_flow_graph(q, *insts_info, mask);
+    if (args->jump_tables) {
+      std::vector<gapstone::DataRegion> data_regions;
+      for (auto &data_section : binary->sections()) {
+        auto data = data_section.content();
+        if (data_section.virtual_address() != 0 && !data.empty()) {
+          data_regions.push_back(
+              {image_base(*binary) + data_section.virtual_address(),
+               data.data(), data.size()});
+        }
+      }
+      auto tables = gapstone_disassembler->find_jump_tables(
+          *insts_info, code.content, mask);
+      // The traversal does not follow tables, so their targets are only
+      // checked for validity there.
+      gapstone::validate_jump_tables(
+          q, *insts_info, args->traverse ? std::vector<uint8_t>() : mask,
+          data_regions, tables);
+      gapstone::add_jump_table_edges(cfg, tables, data_regions);
+      std::cout << "Jump tables: " << std::dec << tables.size() << std::endl;
+    }
+    if (args->edges) {
+      for (uint64_t v = 0; v < cfg.num_vertices; ++v) {
+        for (auto e = cfg.offsets[v]; e < cfg.offsets[v + 1]; ++e) {
+          std::cout << "0x" << std::hex << cfg.address(v) << " -> 0x"
+                    << cfg.address(cfg.columns[e]) << " "
+                    << gapstone::edge_kind_name(cfg.kinds[e]) << std::endl;
+        }
+      }
+    }
+    auto partition =
+        partition_needed
+            ? gapstone::partition_program(q, *insts_info, cfg, mask)
+            : gapstone::ProgramPartition();
+    if (args->call_graph) {
+      auto call_graph = gapstone::build_call_graph(
+          q, *insts_info, partition, collect_import_slots(*binary));
+      std::ofstream out(*args->call_graph);
+      if (std::filesystem::path(*args->call_graph).extension() == ".graphml") {
+        gapstone::write_call_graph_graphml(out, call_graph);
+      } else {
+        gapstone::write_call_graph_dot(out, call_graph);
+      }
+    }
+    if (args->signatures) {
+      auto signatures = gapstone::minhash_signatures(q, *insts_info, partition);
+      std::ofstream out(*args->signatures, std::ios::binary);
+      gapstone::write_minhash_signatures(out, signatures);
+    }
+    if (args->histogram && args->histogram_by_function) {
+      auto histograms = gapstone::function_histograms(
+          q, *insts_info, partition, *args->histogram,
+          histogram_bins(*instruction_info, *args->histogram));
+      for (uint64_t f = 0; f < partition.functions.size(); ++f) {
+        std::cout << "function 0x" << std::hex
+                  << partition.functions[f].entry << std::endl;
+        print_histogram(*instruction_info, *args->histogram, histograms, f);
+      }
+    }
+    if (args->blocks) {
+      auto loops = gapstone::analyze_loop_nests(partition, cfg);
+      for (auto &function : partition.functions) {
+        std::cout << "function 0x" << std::hex << function.entry << std::endl;
+        for (uint64_t k = 0; k < function.num_blocks; ++k) {
+          auto b = partition.function_blocks[function.first_block + k];
+          auto &block = partition.blocks[b];
+          std::cout << "  block 0x" << std::hex << block.start << "-0x"
+                    << block.end << " loop depth " << std::dec
+                    << loops.loop_depth[b] << std::endl;
+        }
+      }
+    }
+  }
+  if (args->histogram && !args->histogram_by_function) {
+    auto histograms = gapstone::section_histograms(
+        q, *insts_info, mask, *args->histogram,
+        histogram_bins(*instruction_info, *args->histogram));
+    for (uint64_t r = 0; r < code.names.size(); ++r) {
+      std::cout << "section " << code.names[r] << std::endl;
+      print_histogram(*instruction_info, *args->histogram, histograms, r);
+    }
+  }
+  if (args->address_pairs) {
+    auto pairs = gapstone_disassembler->resolve_address_pairs(
+        *insts_info, code.content, *args->address_pairs);
+    for (auto &pair : pairs) {
+      std::cout << "0x" << std::hex << pair.page_insn << " 0x"
+                << pair.consumer << " -> 0x" << pair.address << std::endl;
+    }
+  }
+  if (args->prune) {
+    auto keep = gapstone::prune_invalid_chains(q, *insts_info);
+    std::cout << "Candidates after pruning: " << std::dec
+              << std::count(keep.begin(), keep.end(), 1) << " of "
+              << keep.size() << std::endl;
+  }
+  if (args->probabilities) {
+    auto probabilities = gapstone::code_probabilities(q, *insts_info);
+    for (uint64_t i = 0; i < probabilities.size(); ++i) {
+      if (insts_info->status[i] == llvm::MCDisassembler::Fail) {
+        continue;
+      }
+      std::cout << "0x" << std::hex << insts_info->address(i) << " "
+                << format_fixed(probabilities[i]) << std::endl;
+    }
+  }
+  if (args->functions) {
+    auto candidates =
+        gapstone_disassembler->function_starts(*insts_info, code.content);
+    std::cout << "Function start candidates: " << std::dec
+              << candidates.size() << std::endl;
+    for (auto &candidate : candidates) {
+      std::cout << "0x" << std::hex << candidate.address << " score "
+                << std::dec << candidate.score << std::endl;
+    }
+    if (args->skip_padding) {
+      auto hints = gapstone::padding_function_hints(padding.runs, code.ranges);
+      std::cout << "Padding boundary hints: " << std::dec << hints.size()
+                << std::endl;
+      for (auto &hint : hints) {
+        std::cout << "0x" << std::hex << hint.address << std::endl;
       }
     }
   }